@@ -0,0 +1,96 @@
+#include "Arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+//******************** Arena functions ********************************
+
+Arena::Arena(size_t initialBytes)
+    : m_chunks(nullptr), m_next(nullptr), m_end(nullptr), m_used(0)
+{
+    newChunk(max<size_t>(initialBytes, 1024));
+}
+
+Arena::~Arena()
+{
+    freeChunks();
+}
+
+void Arena::freeChunks()
+{
+    while (m_chunks != nullptr)
+    {
+        Chunk* next = m_chunks->next;
+        free(m_chunks);
+        m_chunks = next;
+    }
+}
+
+Arena::Chunk* Arena::newChunk(size_t size)
+{
+    Chunk* c = static_cast<Chunk*>(malloc(sizeof(Chunk) + size));
+    if (c == nullptr)
+        throw bad_alloc();
+    c->next = m_chunks;
+    c->size = size;
+    m_chunks = c;
+    m_next = reinterpret_cast<char*>(c + 1);
+    m_end = m_next + size;
+    return c;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    uintptr_t p = (reinterpret_cast<uintptr_t>(m_next) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    if (p + bytes > reinterpret_cast<uintptr_t>(m_end))
+    {
+        // Chunks at least double, so an arena needs few of them
+        newChunk(max(2 * m_chunks->size, bytes + alignment));
+        p = (reinterpret_cast<uintptr_t>(m_next) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    }
+    m_next = reinterpret_cast<char*>(p + bytes);
+    m_used += bytes;
+    return reinterpret_cast<void*>(p);
+}
+
+//******************** ResourceAllocated functions ********************
+
+namespace
+{
+    // Placed just before every ResourceAllocated object
+    struct alignas(max_align_t) Header
+    {
+        pmr::memory_resource* memory;
+        size_t size;                    // bytes allocated, header included
+    };
+}
+
+void* ResourceAllocated::operator new(size_t size)
+{
+    return operator new(size, pmr::new_delete_resource());
+}
+
+void* ResourceAllocated::operator new(size_t size, pmr::memory_resource* memory)
+{
+    size_t total = sizeof(Header) + size;
+    Header* h = static_cast<Header*>(memory->allocate(total, alignof(Header)));
+    h->memory = memory;
+    h->size = total;
+    return h + 1;
+}
+
+void ResourceAllocated::operator delete(void* p)
+{
+    if (p == nullptr)
+        return;
+    Header* h = static_cast<Header*>(p) - 1;
+    h->memory->deallocate(h, h->size, alignof(Header));
+}
+
+void ResourceAllocated::operator delete(void* p, pmr::memory_resource* /* memory */)
+{
+    operator delete(p);
+}
@@ -0,0 +1,63 @@
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+
+#include <cstddef>
+#include <memory_resource>
+
+// Bump allocator for objects that live as long as the arena, such as the
+// players and boards a tournament worker builds once and resets in place
+// for every game it plays, and every container inside them.  Freeing
+// memory does nothing; everything is given back when the arena goes away.
+// Memory needed only for a while, and freed again, belongs somewhere else,
+// or it piles up for the life of the arena.
+//
+// An arena is not thread-safe.  Give each thread that plays games its own.
+class Arena : public std::pmr::memory_resource
+{
+public:
+    explicit Arena(std::size_t initialBytes = 64 * 1024);
+    ~Arena();
+
+    std::size_t used() const { return m_used; }         // bytes handed out so far
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+private:
+    struct Chunk
+    {
+        Chunk* next;
+        std::size_t size;               // usable bytes after the header
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    Chunk* newChunk(std::size_t size);
+    void freeChunks();
+
+    Chunk* m_chunks;                    // most recent first
+    char* m_next;                       // next free byte in m_chunks
+    char* m_end;                        // end of m_chunks
+    std::size_t m_used;
+};
+
+// Base for classes whose objects may be created in a memory resource with
+// new (resource) T(...) and still be destroyed with a plain delete.  Each
+// object is preceded by a header recording where its memory came from.
+// A plain new uses the heap.
+class ResourceAllocated
+{
+public:
+    static void* operator new(std::size_t size);
+    static void* operator new(std::size_t size, std::pmr::memory_resource* memory);
+    static void operator delete(void* p);
+    // Only called if a constructor throws
+    static void operator delete(void* p, std::pmr::memory_resource* memory);
+
+protected:
+    ~ResourceAllocated() {}
+};
+
+#endif // ARENA_INCLUDED
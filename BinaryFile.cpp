@@ -0,0 +1,40 @@
+#include "BinaryFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+MappedFile::MappedFile(const string& path, Access access)
+    : m_begin(nullptr), m_size(0)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            ::madvise(p, st.st_size, access == SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+            m_begin = static_cast<const char*>(p);
+            m_size = st.st_size;
+        }
+    }
+    ::close(fd);                        // the mapping stays valid
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+void MappedFile::close()
+{
+    if (m_begin != nullptr)
+        ::munmap(const_cast<char*>(m_begin), m_size);
+    m_begin = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,68 @@
+#ifndef BINARYFILE_INCLUDED
+#define BINARYFILE_INCLUDED
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Pieces shared by the binary file formats: game records (GameRecord.h)
+// and opening books (OpeningBook.h).  Values are stored in the byte order
+// of the machine that wrote them.
+namespace BinaryFile
+{
+    // n rounded up to a multiple of 8 bytes
+    inline size_t padded(size_t n)
+    {
+        return (n + 7) & ~size_t(7);
+    }
+
+    template <class T>
+    void put(std::vector<char>& out, T value)
+    {
+        const char* p = reinterpret_cast<const char*>(&value);
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+
+    // Reads a T at p and advances p, unless that would pass end
+    template <class T>
+    bool get(const char*& p, const char* end, T& value)
+    {
+        if (end - p < static_cast<std::ptrdiff_t>(sizeof(T)))
+            return false;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+}
+
+// A whole file mapped read-only into memory for as long as the object
+// lives.  Readers walk their format in place instead of copying it, and
+// every thread can share one mapping.
+class MappedFile
+{
+public:
+    // How the file will be read, passed on to the kernel as a hint
+    enum Access { SEQUENTIAL, RANDOM };
+
+    // Check isOpen() before use; an empty file doesn't open
+    MappedFile(const std::string& path, Access access);
+    ~MappedFile();
+
+    bool isOpen() const { return m_begin != nullptr; }
+    const char* begin() const { return m_begin; }
+    const char* end() const { return m_begin + m_size; }
+    size_t size() const { return m_size; }
+
+    // Unmap early, e.g. once the file turns out not to be what was wanted
+    void close();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+    const char* m_begin;
+    size_t m_size;
+};
+
+#endif // BINARYFILE_INCLUDED
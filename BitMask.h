@@ -0,0 +1,176 @@
+#ifndef BITMASK_INCLUDED
+#define BITMASK_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Fixed-width set of board cells packed into 64-bit words.
+// Cell (r, c) is stored at bit r * cols + c.  BitMask<0> below is the
+// variant sized at run time, for boards too big for a fixed width.
+template <size_t NWords>
+class BitMask
+{
+public:
+    constexpr BitMask() : w() {}
+    explicit BitMask(int /* nCells */, std::pmr::memory_resource* /* memory */ = nullptr) : w() {}
+
+    constexpr void set(int i)           { w[i >> 6] |= bit(i); }
+    void reset(int i)                   { w[i >> 6] &= ~bit(i); }
+    constexpr bool test(int i) const    { return (w[i >> 6] & bit(i)) != 0; }
+
+    void clear()
+    {
+        for (size_t k = 0; k < NWords; k++)
+            w[k] = 0;
+    }
+
+    bool none() const
+    {
+        uint64_t acc = 0;
+        for (size_t k = 0; k < NWords; k++)
+            acc |= w[k];
+        return acc == 0;
+    }
+    bool any() const { return !none(); }
+
+    int count() const
+    {
+        int n = 0;
+        for (size_t k = 0; k < NWords; k++)
+            n += __builtin_popcountll(w[k]);
+        return n;
+    }
+
+    // True if this set and other share at least one cell
+    constexpr bool intersects(const BitMask& other) const
+    {
+        uint64_t acc = 0;
+        for (size_t k = 0; k < NWords; k++)
+            acc |= w[k] & other.w[k];
+        return acc != 0;
+    }
+
+    // Cells in this set that are not in other
+    BitMask andNot(const BitMask& other) const
+    {
+        BitMask result;
+        for (size_t k = 0; k < NWords; k++)
+            result.w[k] = w[k] & ~other.w[k];
+        return result;
+    }
+
+    constexpr BitMask& operator|=(const BitMask& other)
+    {
+        for (size_t k = 0; k < NWords; k++)
+            w[k] |= other.w[k];
+        return *this;
+    }
+
+    BitMask& operator&=(const BitMask& other)
+    {
+        for (size_t k = 0; k < NWords; k++)
+            w[k] &= other.w[k];
+        return *this;
+    }
+
+    BitMask operator|(const BitMask& other) const { BitMask m(*this); return m |= other; }
+    BitMask operator&(const BitMask& other) const { BitMask m(*this); return m &= other; }
+
+    bool operator==(const BitMask& other) const
+    {
+        for (size_t k = 0; k < NWords; k++)
+            if (w[k] != other.w[k])
+                return false;
+        return true;
+    }
+    bool operator!=(const BitMask& other) const { return !(*this == other); }
+
+private:
+    static constexpr uint64_t bit(int i) { return uint64_t(1) << (i & 63); }
+
+    uint64_t w[NWords];
+};
+
+// Set of board cells whose size is chosen when it is constructed.  Its
+// words come from memory if given; copies use the default resource.
+template <>
+class BitMask<0>
+{
+public:
+    BitMask() {}
+    explicit BitMask(int nCells, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : w((nCells + 63) / 64, 0, memory)
+    {}
+
+    void set(int i)         { w[i >> 6] |= bit(i); }
+    void reset(int i)       { w[i >> 6] &= ~bit(i); }
+    bool test(int i) const  { return (w[i >> 6] & bit(i)) != 0; }
+
+    void clear()
+    {
+        for (size_t k = 0; k < w.size(); k++)
+            w[k] = 0;
+    }
+
+    bool none() const
+    {
+        for (size_t k = 0; k < w.size(); k++)
+            if (w[k] != 0)
+                return false;
+        return true;
+    }
+    bool any() const { return !none(); }
+
+    int count() const
+    {
+        int n = 0;
+        for (size_t k = 0; k < w.size(); k++)
+            n += __builtin_popcountll(w[k]);
+        return n;
+    }
+
+    bool intersects(const BitMask& other) const
+    {
+        for (size_t k = 0; k < w.size(); k++)
+            if (w[k] & other.w[k])
+                return true;
+        return false;
+    }
+
+    BitMask andNot(const BitMask& other) const
+    {
+        BitMask result(*this);
+        for (size_t k = 0; k < w.size(); k++)
+            result.w[k] &= ~other.w[k];
+        return result;
+    }
+
+    BitMask& operator|=(const BitMask& other)
+    {
+        for (size_t k = 0; k < w.size(); k++)
+            w[k] |= other.w[k];
+        return *this;
+    }
+
+    BitMask& operator&=(const BitMask& other)
+    {
+        for (size_t k = 0; k < w.size(); k++)
+            w[k] &= other.w[k];
+        return *this;
+    }
+
+    BitMask operator|(const BitMask& other) const { BitMask m(*this); return m |= other; }
+    BitMask operator&(const BitMask& other) const { BitMask m(*this); return m &= other; }
+
+    bool operator==(const BitMask& other) const { return w == other.w; }
+    bool operator!=(const BitMask& other) const { return w != other.w; }
+
+private:
+    static uint64_t bit(int i) { return uint64_t(1) << (i & 63); }
+
+    std::pmr::vector<uint64_t> w;
+};
+
+#endif // BITMASK_INCLUDED
@@ -1,16 +1,54 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "Arena.h"
+#include "BitMask.h"
+#include "Fleet.h"
+#include "Grid.h"
+#include "PlacementTable.h"
+#include "Profiler.h"
+#include "Zobrist.h"
 #include <iostream>
+#include <type_traits>
 #include <vector>
 
 using namespace std;
 
-class BoardImpl
+class BoardImpl : public ResourceAllocated
 {
 public:
-    BoardImpl(const Game& g);           // class constructor
-    ~BoardImpl();                       // class destructor
+    virtual ~BoardImpl() {}
+
+    // Mutators
+    virtual void clear() = 0;
+    virtual void block() = 0;
+    virtual void unblock() = 0;
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) = 0;
+    virtual bool unattack() = 0;
+
+    // Accessors
+    virtual int rows() const = 0;
+    virtual int cols() const = 0;
+    virtual void render(char* out, int stride, bool shotsOnly) const = 0;
+    virtual bool allShipsDestroyed() const = 0;
+    virtual bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const = 0;
+    virtual uint64_t stateHash() const = 0;
+};
+
+// MaxCells > 0 keeps every mask and per-cell array inside the object, sized
+// for a board of at most MaxCells cells.  MaxCells == 0 sizes them from the
+// game at run time.
+//
+// Fleet, if not void, is a FixedFleet the game is known to match: the board
+// size, ship lengths and placement masks are then compile-time constants
+// rather than lookups in the game and its PlacementTable.
+template <size_t MaxCells, class Fleet>
+class BoardImplT : public BoardImpl
+{
+public:
+    BoardImplT(const Game& g);          // class constructor
 
     // Mutators
     void clear();
@@ -19,309 +57,348 @@ public:
     bool placeShip(Point topOrLeft, int shipId, Direction dir);
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    bool unattack();
 
     // Accessors
-    void display(bool shotsOnly) const;
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    void render(char* out, int stride, bool shotsOnly) const;
     bool allShipsDestroyed() const;
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+    uint64_t stateHash() const { return m_hash; }
 private:
-    const Game& m_game;                 // current game instance
-    vector<bool> ship_occured;          // vector keeping track of whether or not each ship has been placed
+    typedef BitMask<(MaxCells + 63) / 64> CellMask;
+    typedef typename conditional<MaxCells == 0, int, short>::type ShipIndex;
+
+    static constexpr bool FIXED = !is_void<Fleet>::value;
 
-    struct cell                         // stores all information at each position in the board
+    int index(int r, int c) const
     {
-        char symbol;
-        bool has_attacked;
-        bool has_hit;
-        int shipId;
-        bool ship_destroyed;
-    };
+        if constexpr (FIXED)
+            return r * Fleet::COLS + c;
+        return r * m_cols + c;
+    }
 
-    cell* g_board[MAXROWS][MAXCOLS];    // grid of cells which will become the board
+    bool isValid(Point p) const
+    {
+        if constexpr (FIXED)
+            return static_cast<unsigned>(p.r) < Fleet::ROWS && static_cast<unsigned>(p.c) < Fleet::COLS;
+        return m_game.isValid(p);
+    }
 
-};
+    int nShips() const
+    {
+        if constexpr (FIXED)
+            return Fleet::N_SHIPS;
+        return m_game.nShips();
+    }
 
-BoardImpl::BoardImpl(const Game& g)
-    : m_game(g), g_board()
-{
-    // All ships have not been placed yet
-    for (size_t i = 0; i < m_game.nShips(); i++)
-        ship_occured.push_back(false);
+    int shipLength(int shipId) const
+    {
+        if constexpr (FIXED)
+            return Fleet::LENGTHS[shipId];
+        return m_table.shipLength(shipId);
+    }
 
-    // Initialize an empty cell at each point in the board
-    for (size_t r = 0; r < m_game.rows(); r++)
-        for (size_t c = 0; c < m_game.cols(); c++)
+    int segmentAt(int shipId, Point topOrLeft, Direction dir) const
+    {
+        if constexpr (FIXED)
+            return Fleet::segmentAt(Fleet::LENGTHS[shipId], topOrLeft.r, topOrLeft.c, dir);
+        return m_table.segmentAt(shipId, topOrLeft, dir);
+    }
+
+    PlacementTable::Segment segment(int shipId, int seg) const
+    {
+        if constexpr (FIXED)
         {
-            g_board[r][c] = new cell;
-            g_board[r][c]->symbol = '.';
-            g_board[r][c]->has_attacked = false;
-            g_board[r][c]->has_hit = false;
-            g_board[r][c]->shipId = -1;
-            g_board[r][c]->ship_destroyed = true;
+            int len = Fleet::LENGTHS[shipId];
+            return PlacementTable::Segment{ Fleet::start(len, seg), Fleet::stride(len, seg),
+                seg < Fleet::nHorizontal(len) ? HORIZONTAL : VERTICAL };
         }
-}
+        return m_table.segment(shipId, seg);
+    }
+
+    const CellMask& mask(int shipId, int seg) const
+    {
+        if constexpr (FIXED)
+            return Fleet::masks().mask(shipId, seg);
+        return m_table.mask(shipId, seg);
+    }
+
+    const Game& m_game;                 // current game instance
+    const PlacementTable& m_table;      // every placement of every ship, shared by all boards of the game
+    int m_rows, m_cols;                 // board dimensions, cached from the game
+    pmr::vector<bool> ship_occured;     // vector keeping track of whether or not each ship has been placed
 
-BoardImpl::~BoardImpl()
+    CellMask m_occupied;                // cells covered by a ship
+    CellMask m_blocked;                 // cells blocked by block()
+    CellMask m_attacked;                // cells that have been shot at (hits are m_attacked & m_occupied)
+
+    struct ShipState                    // fleet status of each ship, indexed by shipId
+    {
+        Point topOrLeft;
+        Direction dir;
+        int remaining;                  // segments of the ship not yet hit
+    };
+    pmr::vector<ShipState> m_ships;
+    int m_shipsRemaining;               // placed ships that have not been destroyed
+    Grid<ShipIndex, MaxCells> m_cellShip;   // shipId at each cell, or -1 if empty
+
+    pmr::vector<int> m_undo;            // cells attacked that unattack can take back, oldest first
+    uint64_t m_hash;                    // Zobrist hash of the shot results so far
+};
+
+template <size_t MaxCells, class Fleet>
+BoardImplT<MaxCells, Fleet>::BoardImplT(const Game& g)
+    : m_game(g), m_table(g.placementTable()), m_rows(g.rows()), m_cols(g.cols()),
+      ship_occured(g.nShips(), false, g.memory()),
+      m_occupied(m_rows * m_cols, g.memory()), m_blocked(m_rows * m_cols, g.memory()),
+      m_attacked(m_rows * m_cols, g.memory()),
+      m_ships(g.nShips(), g.memory()), m_shipsRemaining(0), m_cellShip(m_rows, m_cols, g.memory()),
+      m_undo(g.memory()), m_hash(0)
 {
-    // Delete each cell in the board
-    for (int r = 0; r < m_game.rows(); r++)
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            delete g_board[r][c];
-        }
+    m_cellShip.fill(-1);
+    m_undo.reserve(m_rows * m_cols);    // every cell is attacked at most once
 }
 
-void BoardImpl::clear()
+template <size_t MaxCells, class Fleet>
+void BoardImplT<MaxCells, Fleet>::clear()
 {
     // Clear the board
-    // Delete each cell in the old board and replace them with newly initialized ones
-    for (size_t r = 0; r < m_game.rows(); r++)
-        for (size_t c = 0; c < m_game.cols(); c++)
-        {
-            delete g_board[r][c];
-            g_board[r][c] = new cell;
-            g_board[r][c]->symbol = '.';
-            g_board[r][c]->has_attacked = false;
-            g_board[r][c]->has_hit = false;
-            g_board[r][c]->shipId = -1;
-            g_board[r][c]->ship_destroyed = true;
-        }
+    m_occupied.clear();
+    m_blocked.clear();
+    m_attacked.clear();
+    m_cellShip.fill(-1);
 
     // All ships have not been replaced yet
-    for (size_t i = 0; i < m_game.nShips(); i++)
-        if (i < ship_occured.size())
-            ship_occured.at(i) = false;
+    for (size_t i = 0; i < ship_occured.size(); i++)
+        ship_occured.at(i) = false;
+    m_shipsRemaining = 0;
+    m_undo.clear();
+    m_hash = 0;
 }
 
-void BoardImpl::block()     // check
+template <size_t MaxCells, class Fleet>
+void BoardImplT<MaxCells, Fleet>::block()     // check
 {
     // Block half the cells on the board
-    int count = 0;
-    int num_cells = m_game.rows() * m_game.cols();
-    while (count != (num_cells / 2))
+    int count = m_blocked.count();
+    int num_cells = m_rows * m_cols;
+    while (count < (num_cells / 2))
     {
         Point current = m_game.randomPoint();
-        if (g_board[current.r][current.c]->symbol != 'X')
+        int i = index(current.r, current.c);
+        if (!m_blocked.test(i))
         {
-            g_board[current.r][current.c]->symbol = 'X';
+            m_blocked.set(i);
             ++count;
         }
-
     }
 }
 
-void BoardImpl::unblock()   // check
+template <size_t MaxCells, class Fleet>
+void BoardImplT<MaxCells, Fleet>::unblock()   // check
 {
     // Unblock all currently blocked cells on the board
-    for (int r = 0; r < m_game.rows(); r++)
-        for (int c = 0; c < m_game.cols(); c++)
-            if (g_board[r][c]->symbol == 'X')
-                g_board[r][c]->symbol = '.';
-
+    m_blocked.clear();
 }
 
-bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+template <size_t MaxCells, class Fleet>
+bool BoardImplT<MaxCells, Fleet>::placeShip(Point topOrLeft, int shipId, Direction dir)
 {
     // If a shipId that doesn't exist is inputted, return false
-    if (shipId >= m_game.nShips() || shipId < 0)
+    if (shipId >= nShips() || shipId < 0)
         return false;
 
     // If the inputted ship has already been placed, return false
     if (ship_occured.at(shipId))
         return false;
 
-    if (dir == VERTICAL)                // Place the ship vertically
+    // If placing the inputted ship at the inputted position isn't possible, return false
+    int seg = segmentAt(shipId, topOrLeft, dir);
+    if (seg < 0)
+        return false;
+    PlacementTable::Segment s = segment(shipId, seg);
+    int length = shipLength(shipId);
+
+    // If an occupied or blocked cell exists anywhere where we're trying to place our ship, return false.
+    // Otherwise place our ship and count the cells that haven't been attacked yet.
+    int remaining = 0;
+    if constexpr (MaxCells != 0)
     {
-        // If placing the inputted ship at the inputted position isn't possible, return false
-        if ((topOrLeft.r + m_game.shipLength(shipId) - 1) >= m_game.rows() || topOrLeft.c >= m_game.cols() || topOrLeft.r < 0 || topOrLeft.c < 0)
+        const CellMask& cells = mask(shipId, seg);
+        if (cells.intersects(m_occupied) || cells.intersects(m_blocked))
             return false;
-
-        // If an unempty cell exists anywhere where we're trying to place our ship, return false
-        for (int i = topOrLeft.r; i < (topOrLeft.r + m_game.shipLength(shipId)); i++)
-            if (g_board[i][topOrLeft.c]->symbol != '.')
-                return false;
-
-        // Place our ship and update corresponding cells in board
-        for (int i = topOrLeft.r; i < (topOrLeft.r + m_game.shipLength(shipId)); i++)
-        {
-            g_board[i][topOrLeft.c]->symbol = m_game.shipSymbol(shipId);
-            g_board[i][topOrLeft.c]->shipId = shipId;
-            g_board[i][topOrLeft.c]->ship_destroyed = false;
-        }
-
-        ship_occured.at(shipId) = true;                 // Inputted ship has been placed
-
-        return true;                // Ship was successfully placed      
+        m_occupied |= cells;
+        remaining = length - (cells & m_attacked).count();
     }
-
-
-    else                            // Place the ship horizontally
+    else
     {
-        // If placing the inputted ship at the inputted position isn't possible, return false 
-        if (topOrLeft.r >= m_game.rows() || (topOrLeft.c + m_game.shipLength(shipId) - 1) >= m_game.cols() || topOrLeft.r < 0 || topOrLeft.c < 0)
-            return false;
-
-        // If an unempty cell exists anywhere where we're trying to place our ship, return false
-        for (int i = topOrLeft.c; i < (topOrLeft.c + m_game.shipLength(shipId)); i++)
-            if (g_board[topOrLeft.r][i]->symbol != '.')
+        for (int k = 0, i = s.start; k < length; k++, i += s.stride)
+            if (m_occupied.test(i) || m_blocked.test(i))
                 return false;
-
-        // Place our ship and update corresponding cells in board
-        for (int i = topOrLeft.c; i < (topOrLeft.c + m_game.shipLength(shipId)); i++)
+        for (int k = 0, i = s.start; k < length; k++, i += s.stride)
         {
-            g_board[topOrLeft.r][i]->symbol = m_game.shipSymbol(shipId);
-            g_board[topOrLeft.r][i]->shipId = shipId;
-            g_board[topOrLeft.r][i]->ship_destroyed = false;
+            m_occupied.set(i);
+            if (!m_attacked.test(i))
+                ++remaining;
         }
-
-        ship_occured.at(shipId) = true;                 // Inputted ship has been placed
-
-        return true;                // Ship was successfully placed
     }
+    for (int k = 0, i = s.start; k < length; k++, i += s.stride)
+        m_cellShip[i] = static_cast<ShipIndex>(shipId);
+    m_ships[shipId].topOrLeft = topOrLeft;
+    m_ships[shipId].dir = dir;
+    m_ships[shipId].remaining = remaining;
+    if (remaining > 0)
+        ++m_shipsRemaining;
+
+    ship_occured.at(shipId) = true;     // Inputted ship has been placed
+    m_undo.clear();                     // Earlier attacks no longer match the fleet
+
+    return true;                        // Ship was successfully placed
 }
 
-bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+template <size_t MaxCells, class Fleet>
+bool BoardImplT<MaxCells, Fleet>::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 {
     // Remove inputted ship from board
 
-    if (shipId >= m_game.nShips() || shipId < 0)        // If shipId isn't valid, return false
+    if (shipId >= nShips() || shipId < 0)               // If shipId isn't valid, return false
         return false;
 
-    // If inputted start position isn't valid, return false
-    if (topOrLeft.r >= m_game.rows() || topOrLeft.c >= m_game.cols() || topOrLeft.r < 0 || topOrLeft.c < 0)
+    if (!ship_occured.at(shipId))                       // If the ship isn't on the board, return false
         return false;
 
-    // If inputted position doesn't contain inputted ship, return false
-    if (g_board[topOrLeft.r][topOrLeft.c]->symbol != m_game.shipSymbol(shipId))
+    // If the ship wasn't placed at exactly the inputted position, return false
+    const ShipState& placed = m_ships[shipId];
+    if (placed.topOrLeft.r != topOrLeft.r || placed.topOrLeft.c != topOrLeft.c || placed.dir != dir)
         return false;
 
-    if (dir == VERTICAL)                    // Ship is placed vertically
+    // Clear all cells containing the inputted ship
+    int seg = segmentAt(shipId, topOrLeft, dir);
+    PlacementTable::Segment s = segment(shipId, seg);
+    if constexpr (MaxCells != 0)
+        m_occupied = m_occupied.andNot(mask(shipId, seg));
+    for (int k = 0, i = s.start; k < shipLength(shipId); k++, i += s.stride)
     {
-        // If the ship's location is inaccurate, return false
-        for (int i = (topOrLeft.r + 1); i < (topOrLeft.r + m_game.shipLength(shipId)); i++)
-            if (g_board[i][topOrLeft.c]->symbol != m_game.shipSymbol(shipId) || i >= m_game.rows())
-                return false;
-
-        // Clear all cells containing the inputted ship
-        for (int i = topOrLeft.r; i < (topOrLeft.r + m_game.shipLength(shipId) + 1); i++)
-        {
-            g_board[i][topOrLeft.c]->symbol = '.';
-            g_board[i][topOrLeft.c]->shipId = -1;
-            g_board[i][topOrLeft.c]->ship_destroyed = true;
-        }
-
-        ship_occured.at(shipId) = false;                // Ship no longer occurs on board
-
-        return true;                                    // Ship removal was successful
+        if constexpr (MaxCells == 0)
+            m_occupied.reset(i);
+        m_cellShip[i] = -1;
     }
+    if (placed.remaining > 0)
+        --m_shipsRemaining;
 
+    ship_occured.at(shipId) = false;    // Ship no longer occurs on board
+    m_undo.clear();                     // Earlier attacks no longer match the fleet
 
-    else                                                // Ship was placed horizontally
-    {
-        // If the ship's location is inaccurate, return false
-        for (int i = (topOrLeft.c + 1); i < (topOrLeft.c + m_game.shipLength(shipId)); i++)
-            if (g_board[i][topOrLeft.c]->symbol != m_game.shipSymbol(shipId) || i >= m_game.rows())
-                return false;
-
-        // Clear all cells containing the inputted ship
-        for (int i = topOrLeft.c; i < (topOrLeft.c + m_game.shipLength(shipId) + 1); i++)
-        {
-            g_board[topOrLeft.r][i]->symbol = '.';
-            g_board[topOrLeft.r][i]->shipId = -1;
-            g_board[topOrLeft.c][i]->ship_destroyed = true;
-        }
-
-        ship_occured.at(shipId) = false;                // Ship no longer occurs on board
-
-        return true;                                    // Ship removal was successful 
-    }
+    return true;                        // Ship removal was successful
 }
 
-void BoardImpl::display(bool shotsOnly) const
+template <size_t MaxCells, class Fleet>
+void BoardImplT<MaxCells, Fleet>::render(char* out, int stride, bool shotsOnly) const
 {
-    // Display current board
-
-    // Display column labels
-    cout << "  ";
-    for (int c = 0; c < m_game.cols(); c++)
-        cout << c;
-    cout << endl;
-
-    for (int r = 0; r < m_game.rows(); r++)
+    // For each cell, if attacked, show the result.  If not, show either its
+    // true symbol or the empty symbol.
+    for (int r = 0; r < m_rows; r++, out += stride)
     {
-        cout << r << ' ';               // Display row label
-
-        // For each column value, if attacked, display result. If not, display either true symbol or empty symbol
-
-        for (int c = 0; c < m_game.cols(); c++)
+        for (int c = 0; c < m_cols; c++)
         {
-            if (g_board[r][c]->has_attacked)
-            {
-                if (g_board[r][c]->has_hit)
-                    cout << 'X';
-                else
-                    cout << 'o';
-            }
-            else if (!shotsOnly)
-                cout << g_board[r][c]->symbol;
+            int i = index(r, c);
+            if (m_attacked.test(i))
+                out[c] = (m_occupied.test(i) ? 'X' : 'o');
+            else if (shotsOnly)
+                out[c] = '.';
+            else if (m_blocked.test(i))
+                out[c] = 'X';
+            else if (m_cellShip[i] >= 0)
+                out[c] = m_game.shipSymbol(m_cellShip[i]);
             else
-                cout << '.';
+                out[c] = '.';
         }
-        cout << '\n';
     }
-
 }
 
-bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+template <size_t MaxCells, class Fleet>
+bool BoardImplT<MaxCells, Fleet>::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
     // If inputted position isn't on board, return false
-    if (!m_game.isValid(p))
+    if (!isValid(p))
         return false;
 
     // If inputted position has already been attacked, return false
-    if (g_board[p.r][p.c]->has_attacked)
+    int i = index(p.r, p.c);
+    if (m_attacked.test(i))
         return false;
 
-    g_board[p.r][p.c]->has_attacked = true;         // Inputted position has now been attacked
+    m_attacked.set(i);                  // Inputted position has now been attacked
+    m_undo.push_back(i);
 
-
-    if (g_board[p.r][p.c]->symbol != '.' && g_board[p.r][p.c]->has_hit == false)        // If attack hits a ship
+    shipDestroyed = false;
+    if (m_occupied.test(i))             // If attack hits a ship
     {
-        // Position has now been hit
-        g_board[p.r][p.c]->has_hit = true;
         shotHit = true;
-        int current_shipId = g_board[p.r][p.c]->shipId;
-        shipDestroyed = true;
-
-        // If another part of hit ship hasn't been hit yet, ship is not yet destroyed
-        for (int r = 0; r < m_game.rows(); r++)
-            for (int c = 0; c < m_game.cols(); c++)
-                if (g_board[r][c]->shipId == current_shipId && !g_board[r][c]->has_hit)
-                    shipDestroyed = false;
+        m_hash ^= Zobrist::hit(i);
 
-        if (shipDestroyed)
+        // The ship is destroyed once its last segment is hit
+        int current_shipId = m_cellShip[i];
+        if (--m_ships[current_shipId].remaining == 0)
         {
-            // If ship was destroyed, record this result
-            shipId = g_board[p.r][p.c]->shipId;
-            for (int r = 0; r < m_game.rows(); r++)
-                for (int c = 0; c < m_game.cols(); c++)
-                    if (g_board[r][c]->shipId == shipId)
-                        g_board[r][c]->ship_destroyed = true;
+            shipDestroyed = true;
+            shipId = current_shipId;
+            --m_shipsRemaining;
+            m_hash ^= Zobrist::sunk(current_shipId);
         }
-
     }
-    else                            // attack missed
+    else                                // attack missed
+    {
         shotHit = false;
+        m_hash ^= Zobrist::miss(i);
+    }
 
-    return true;                    // attack was successfully executed
+    return true;                        // attack was successfully executed
 }
 
-bool BoardImpl::allShipsDestroyed() const
+template <size_t MaxCells, class Fleet>
+bool BoardImplT<MaxCells, Fleet>::unattack()
 {
-    // If all ships have been destroyed, return true. Otherwise, return false
-    for (int r = 0; r < m_game.rows(); r++)
-        for (int c = 0; c < m_game.cols(); c++)
-            if (g_board[r][c]->ship_destroyed == false && g_board[r][c]->shipId != -1)
-                return false;
+    if (m_undo.empty())
+        return false;
+    int i = m_undo.back();
+    m_undo.pop_back();
+    m_attacked.reset(i);
+
+    if (m_occupied.test(i))
+    {
+        m_hash ^= Zobrist::hit(i);
+
+        // Attacks are taken back latest first, so a sunk ship was sunk by this one
+        int current_shipId = m_cellShip[i];
+        if (m_ships[current_shipId].remaining++ == 0)
+        {
+            ++m_shipsRemaining;
+            m_hash ^= Zobrist::sunk(current_shipId);
+        }
+    }
+    else
+        m_hash ^= Zobrist::miss(i);
+
+    return true;
+}
+
+template <size_t MaxCells, class Fleet>
+bool BoardImplT<MaxCells, Fleet>::allShipsDestroyed() const
+{
+    // If no placed ship is left standing, return true. Otherwise, return false
+    return m_shipsRemaining == 0;
+}
+
+template <size_t MaxCells, class Fleet>
+bool BoardImplT<MaxCells, Fleet>::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    if (shipId >= nShips() || shipId < 0 || !ship_occured.at(shipId))
+        return false;
+    topOrLeft = m_ships[shipId].topOrLeft;
+    dir = m_ships[shipId].dir;
     return true;
 }
 
@@ -332,7 +409,12 @@ bool BoardImpl::allShipsDestroyed() const
 
 Board::Board(const Game& g)
 {
-    m_impl = new BoardImpl(g);
+    if (g.rows() * g.cols() > SMALL_BOARD_CELLS)
+        m_impl = new (g.memory()) BoardImplT<0, void>(g);
+    else if (StandardFleet::matches(g.placementTable()))
+        m_impl = new (g.memory()) BoardImplT<SMALL_BOARD_CELLS, StandardFleet>(g);
+    else
+        m_impl = new (g.memory()) BoardImplT<SMALL_BOARD_CELLS, void>(g);
 }
 
 Board::~Board()
@@ -345,6 +427,12 @@ void Board::clear()
     m_impl->clear();
 }
 
+void Board::reset()
+{
+    // A cleared board has no ships, blocks or shots, just like a new one
+    m_impl->clear();
+}
+
 void Board::block()
 {
     return m_impl->block();
@@ -367,15 +455,74 @@ bool Board::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 
 void Board::display(bool shotsOnly) const
 {
-    m_impl->display(shotsOnly);
+    PROFILE_SCOPE("board.display");
+
+    // The whole board is built in one buffer, kept between calls, and
+    // sent to cout in a single write
+    static thread_local string text;
+    text.clear();
+    appendText(text, shotsOnly);
+    cout.write(text.data(), text.size());
+    cout.flush();
+}
+
+void Board::appendText(string& out, bool shotsOnly) const
+{
+    int rows = m_impl->rows();
+    int cols = m_impl->cols();
+
+    // Row labels are padded to the widest one; boards wider than 10 columns
+    // label each column with its last digit
+    int labelWidth = 1;
+    for (int n = rows - 1; n >= 10; n /= 10)
+        labelWidth++;
+
+    // Column labels, then each row after its label
+    size_t start = out.size();
+    size_t lineWidth = labelWidth + 1 + cols + 1;
+    out.resize(start + (rows + 1) * lineWidth, ' ');
+    char* line = &out[start];
+    for (int c = 0; c < cols; c++)
+        line[labelWidth + 1 + c] = '0' + c % 10;
+    line[lineWidth - 1] = '\n';
+
+    for (int r = 0; r < rows; r++)
+    {
+        line += lineWidth;
+        for (int n = r, k = labelWidth - 1; k >= 0 && (k == labelWidth - 1 || n > 0); n /= 10, k--)
+            line[k] = '0' + n % 10;
+        line[lineWidth - 1] = '\n';
+    }
+    m_impl->render(&out[start] + lineWidth + labelWidth + 1, static_cast<int>(lineWidth), shotsOnly);
+}
+
+void Board::render(char* out, int stride, bool shotsOnly) const
+{
+    m_impl->render(out, stride, shotsOnly);
 }
 
 bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
+    PROFILE_SCOPE("board.attack");
     return m_impl->attack(p, shotHit, shipDestroyed, shipId);
 }
 
+bool Board::unattack()
+{
+    return m_impl->unattack();
+}
+
 bool Board::allShipsDestroyed() const
 {
     return m_impl->allShipsDestroyed();
 }
+
+bool Board::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    return m_impl->shipPlacement(shipId, topOrLeft, dir);
+}
+
+uint64_t Board::stateHash() const
+{
+    return m_impl->stateHash();
+}
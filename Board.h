@@ -2,6 +2,7 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <string>
 
 class Game;
 class BoardImpl;
@@ -12,13 +13,26 @@ public:
     Board(const Game& g);
     ~Board();
     void clear();
+    void reset();                       // Back to the state right after construction, without allocating
     void block();
     void unblock();
     bool placeShip(Point topOrLeft, int shipId, Direction dir);
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    // Print the board to cout, in one write
     void display(bool shotsOnly) const;
+    // Append the text display prints to out
+    void appendText(std::string& out, bool shotsOnly) const;
+    // Write the symbol of each cell, row r starting at out + r * stride
+    void render(char* out, int stride, bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    // Take back the latest attack not yet taken back; false if there is none.
+    // Placing or removing a ship makes every earlier attack permanent.
+    bool unattack();
     bool allShipsDestroyed() const;
+    // Zobrist hash of the misses, hits and sunk ships reported so far
+    uint64_t stateHash() const;
+    // Where ship shipId was placed; false if it isn't on the board
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
     // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
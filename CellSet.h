@@ -0,0 +1,84 @@
+#ifndef CELLSET_INCLUDED
+#define CELLSET_INCLUDED
+
+#include "globals.h"
+#include <memory_resource>
+#include <vector>
+
+// Set of board cells, numbered r * cols + c, with constant-time insert,
+// erase, membership test and uniformly random pick.  The members are kept
+// packed at the front of one array and every cell records where it sits
+// in that array, so erasing moves the last member into the hole.  Erasing
+// changes the order of the remaining members.
+class CellSet
+{
+public:
+    typedef std::pmr::vector<int>::const_iterator const_iterator;
+
+    // Empty set of cells numbered 0 to nCells - 1, stored in memory
+    explicit CellSet(int nCells, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : m_members(memory), m_pos(nCells, -1, memory)
+    {
+        m_members.reserve(nCells);
+    }
+
+    int size() const { return static_cast<int>(m_members.size()); }
+    bool empty() const { return m_members.empty(); }
+    bool contains(int cell) const { return m_pos[cell] >= 0; }
+
+    // Members in their current order
+    int operator[](int k) const { return m_members[k]; }
+    const_iterator begin() const { return m_members.begin(); }
+    const_iterator end() const { return m_members.end(); }
+
+    // Returns false if cell was already a member
+    bool insert(int cell)
+    {
+        if (m_pos[cell] >= 0)
+            return false;
+        m_pos[cell] = static_cast<int>(m_members.size());
+        m_members.push_back(cell);
+        return true;
+    }
+
+    // Returns false if cell wasn't a member
+    bool erase(int cell)
+    {
+        int k = m_pos[cell];
+        if (k < 0)
+            return false;
+        int last = m_members.back();
+        m_members[k] = last;
+        m_pos[last] = k;
+        m_members.pop_back();
+        m_pos[cell] = -1;
+        return true;
+    }
+
+    // Make every cell a member, in increasing order
+    void fill()
+    {
+        m_members.resize(m_pos.size());
+        for (size_t i = 0; i < m_pos.size(); i++)
+        {
+            m_members[i] = static_cast<int>(i);
+            m_pos[i] = static_cast<int>(i);
+        }
+    }
+
+    void clear()
+    {
+        for (size_t k = 0; k < m_members.size(); k++)
+            m_pos[m_members[k]] = -1;
+        m_members.clear();
+    }
+
+    // A uniformly random member; the set must not be empty
+    int random(Rng& rng) const { return m_members[rng.nextInt(size())]; }
+
+private:
+    std::pmr::vector<int> m_members;    // the members, packed
+    std::pmr::vector<int> m_pos;        // index of each cell in m_members, or -1
+};
+
+#endif // CELLSET_INCLUDED
@@ -0,0 +1,142 @@
+#ifndef FLEET_INCLUDED
+#define FLEET_INCLUDED
+
+#include "globals.h"
+#include "PlacementTable.h"
+
+template <class Fleet> class FleetMasks;
+
+// A board size and fleet fixed at compile time.  Games whose placement
+// table matches one can run kernels instantiated for it, in which every
+// ship length, placement count and placement mask is a constant; any other
+// board or fleet takes the general path through PlacementTable.
+//
+// Placements are numbered exactly as PlacementTable numbers them, so both
+// paths agree on every placement number and make the same random draws.
+template <int Rows, int Cols, int... Lengths>
+struct FixedFleet
+{
+    typedef PlacementTable::SmallMask Mask;
+
+    static constexpr int ROWS = Rows;
+    static constexpr int COLS = Cols;
+    static constexpr int CELLS = Rows * Cols;
+    static constexpr int N_SHIPS = sizeof...(Lengths);
+    static constexpr int LENGTHS[N_SHIPS] = { Lengths... };
+
+    static_assert(CELLS <= SMALL_BOARD_CELLS, "a fixed fleet's board must fit in a SmallMask");
+    static_assert(((Lengths >= 1 && (Lengths <= Rows || Lengths <= Cols)) && ...),
+        "every ship of a fixed fleet must fit on its board");
+
+    // Placements of a ship of length len, horizontal ones first
+    static constexpr int nHorizontal(int len) { return len <= Cols ? Rows * (Cols - len + 1) : 0; }
+    static constexpr int nSegments(int len) { return nHorizontal(len) + (len <= Rows ? (Rows - len + 1) * Cols : 0); }
+
+    // Top or left cell of placement k of a ship of length len
+    static constexpr int start(int len, int k)
+    {
+        return k < nHorizontal(len) ? (k / (Cols - len + 1)) * Cols + k % (Cols - len + 1) : k - nHorizontal(len);
+    }
+    static constexpr int stride(int len, int k) { return k < nHorizontal(len) ? 1 : Cols; }
+
+    // Number of the placement at (r, c), or -1 if it leaves the board
+    static constexpr int segmentAt(int len, int r, int c, Direction dir)
+    {
+        if (r < 0 || c < 0)
+            return -1;
+        if (dir == HORIZONTAL)
+            return (r < Rows && c + len <= Cols ? r * (Cols - len + 1) + c : -1);
+        return (r + len <= Rows && c < Cols ? nHorizontal(len) + r * Cols + c : -1);
+    }
+
+    // Ships of length len in the fleet
+    static constexpr int multiplicity(int len)
+    {
+        int n = 0;
+        for (int other : LENGTHS)
+            n += (other == len);
+        return n;
+    }
+
+    // True if no ship before shipId has its length
+    static constexpr bool firstOfLength(int shipId)
+    {
+        for (int k = 0; k < shipId; k++)
+            if (LENGTHS[k] == LENGTHS[shipId])
+                return false;
+        return true;
+    }
+
+    static constexpr int maxSegments()
+    {
+        int most = 0;
+        for (int len : LENGTHS)
+            most = (nSegments(len) > most ? nSegments(len) : most);
+        return most;
+    }
+
+    // Cells of every placement of every ship, built by the compiler
+    static const FleetMasks<FixedFleet>& masks();
+
+    // True if table is for this board size and fleet, ship for ship
+    static bool matches(const PlacementTable& table)
+    {
+        if (table.rows() != Rows || table.cols() != Cols || table.nShips() != N_SHIPS)
+            return false;
+        for (int shipId = 0; shipId < N_SHIPS; shipId++)
+            if (table.shipLength(shipId) != LENGTHS[shipId])
+                return false;
+        return true;
+    }
+};
+
+// The fleet main.cpp and the tools play with by default
+typedef FixedFleet<10, 10, 5, 4, 3, 3, 2> StandardFleet;
+
+// Mask and halo of each placement of each ship of Fleet, as
+// PlacementTable::mask and PlacementTable::halo give them
+template <class Fleet>
+class FleetMasks
+{
+public:
+    typedef typename Fleet::Mask Mask;
+
+    constexpr FleetMasks() : m_masks(), m_halos()
+    {
+        for (int shipId = 0; shipId < Fleet::N_SHIPS; shipId++)
+        {
+            int len = Fleet::LENGTHS[shipId];
+            for (int k = 0; k < Fleet::nSegments(len); k++)
+            {
+                for (int j = 0, i = Fleet::start(len, k); j < len; j++, i += Fleet::stride(len, k))
+                {
+                    int r = i / Fleet::COLS;
+                    int c = i % Fleet::COLS;
+                    m_masks[shipId][k].set(i);
+                    m_halos[shipId][k].set(i);
+                    if (r > 0)                  m_halos[shipId][k].set(i - Fleet::COLS);
+                    if (r < Fleet::ROWS - 1)    m_halos[shipId][k].set(i + Fleet::COLS);
+                    if (c > 0)                  m_halos[shipId][k].set(i - 1);
+                    if (c < Fleet::COLS - 1)    m_halos[shipId][k].set(i + 1);
+                }
+            }
+        }
+    }
+
+    const Mask& mask(int shipId, int k) const { return m_masks[shipId][k]; }
+    const Mask& halo(int shipId, int k) const { return m_halos[shipId][k]; }
+
+private:
+    Mask m_masks[Fleet::N_SHIPS][Fleet::maxSegments()];
+    Mask m_halos[Fleet::N_SHIPS][Fleet::maxSegments()];
+};
+
+template <int Rows, int Cols, int... Lengths>
+const FleetMasks<FixedFleet<Rows, Cols, Lengths...> >& FixedFleet<Rows, Cols, Lengths...>::masks()
+{
+    // Constant-initialized: no guard and no work at run time
+    static constexpr FleetMasks<FixedFleet> table;
+    return table;
+}
+
+#endif // FLEET_INCLUDED
@@ -0,0 +1,244 @@
+#include "FrameRenderer.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+    // Each board gets at least this many columns, so most titles fit
+    const int MIN_BOARD_WIDTH = 20;
+
+    // Unchanged cells between two changed ones that are cheaper to rewrite
+    // than to skip with another cursor move
+    const int MAX_GAP_REWRITTEN = 6;
+
+    const char CLEAR_SCREEN[] = "\x1b[H\x1b[2J";
+    const char CLEAR_TO_EOL[] = "\x1b[K";
+}
+
+//******************** FrameRenderer functions **********************
+
+FrameRenderer::FrameRenderer(const Game& g, Mode mode)
+    : m_mode(mode), m_rows(g.rows()), m_cols(g.cols()), m_shownValid(false)
+{
+    m_labelWidth = 1;
+    for (int n = m_rows - 1; n >= 10; n /= 10)
+        m_labelWidth++;
+    m_boardWidth = max(m_labelWidth + 1 + m_cols, MIN_BOARD_WIDTH);
+
+    // Titles, column labels, then the rows
+    m_width = 2 * m_boardWidth + GAP;
+    m_height = m_rows + 2;
+    m_frame.assign(m_width * m_height, ' ');
+    m_shown.assign(m_width * m_height, ' ');
+}
+
+void FrameRenderer::draw(const Board* left, bool leftShotsOnly, const string& leftTitle,
+    const Board* right, bool rightShotsOnly, const string& rightTitle,
+    const string& status)
+{
+    fill(m_frame.begin(), m_frame.end(), ' ');
+    drawBoard(left, leftShotsOnly, leftTitle, 0);
+    drawBoard(right, rightShotsOnly, rightTitle, m_boardWidth + GAP);
+    m_status = status;
+}
+
+void FrameRenderer::drawBoard(const Board* b, bool shotsOnly, const string& title, int left)
+{
+    if (b == nullptr)
+        return;
+
+    char* top = &m_frame[left];
+    title.copy(top, min(title.size(), static_cast<size_t>(m_boardWidth)));
+
+    // As Board::display lays out a board
+    char* line = top + m_width;
+    for (int c = 0; c < m_cols; c++)
+        line[m_labelWidth + 1 + c] = '0' + c % 10;
+    for (int r = 0; r < m_rows; r++)
+    {
+        line += m_width;
+        for (int n = r, k = m_labelWidth - 1; k >= 0 && (k == m_labelWidth - 1 || n > 0); n /= 10, k--)
+            line[k] = '0' + n % 10;
+    }
+    b->render(top + 2 * m_width + m_labelWidth + 1, m_width, shotsOnly);
+}
+
+void FrameRenderer::appendMove(int row, int col)
+{
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "\x1b[%d;%dH", row + 1, col + 1);
+    m_out.append(buf, n);
+}
+
+void FrameRenderer::present(ostream& out)
+{
+    PROFILE_SCOPE("frame.present");
+    m_out.clear();
+
+    if (m_mode == PLAIN || !m_shownValid)
+    {
+        // The whole frame, without the blanks at the end of each line
+        if (m_mode == ANSI)
+            m_out += CLEAR_SCREEN;
+        for (int r = 0; r < m_height; r++)
+        {
+            const char* line = &m_frame[r * m_width];
+            int len = m_width;
+            while (len > 0 && line[len - 1] == ' ')
+                len--;
+            m_out.append(line, len);
+            m_out += '\n';
+        }
+        m_out += m_status;
+        m_out += '\n';
+        if (m_mode == ANSI)
+        {
+            m_shown = m_frame;
+            m_shownStatus = m_status;
+            m_shownValid = true;
+        }
+    }
+    else
+    {
+        // Only the runs of cells that differ from what is on the screen,
+        // with short stretches of unchanged cells between them rewritten
+        // rather than skipped
+        for (int r = 0; r < m_height; r++)
+        {
+            const char* now = &m_frame[r * m_width];
+            char* shown = &m_shown[r * m_width];
+            int c = 0;
+            while (c < m_width)
+            {
+                if (now[c] == shown[c])
+                {
+                    c++;
+                    continue;
+                }
+                int start = c;
+                int end = c + 1;
+                for (c++; c < m_width && c - end <= MAX_GAP_REWRITTEN; c++)
+                    if (now[c] != shown[c])
+                        end = c + 1;
+                appendMove(r, start);
+                m_out.append(now + start, end - start);
+                copy(now + start, now + end, shown + start);
+                c = end;
+            }
+        }
+        if (m_status != m_shownStatus)
+        {
+            appendMove(m_height, 0);
+            m_out += m_status;
+            m_out += CLEAR_TO_EOL;
+            m_shownStatus = m_status;
+        }
+        // Leave the cursor below the frame, as a full frame does
+        appendMove(m_height + 1, 0);
+    }
+
+    out.write(m_out.data(), m_out.size());
+    out.flush();
+}
+
+//******************** FrameEventSink functions *********************
+
+FrameEventSink::FrameEventSink(const Game& g, FrameRenderer::Mode mode, int delayMs)
+    : m_game(g), m_renderer(g, mode), m_delayMs(delayMs),
+      m_attackers{ nullptr, nullptr }, m_defenders{ nullptr, nullptr }, m_boards{ nullptr, nullptr }
+{}
+
+void FrameEventSink::show(const string& status, const Board* revealed)
+{
+    // A human attacker sees only their own shots on the board they attack
+    bool shotsOnly[2];
+    string titles[2];
+    for (int side = 0; side < 2; side++)
+    {
+        shotsOnly[side] = m_attackers[side] != nullptr && m_attackers[side]->isHuman() &&
+            m_boards[side] != revealed;
+        if (m_defenders[side] != nullptr)
+            titles[side] = m_defenders[side]->name();
+    }
+    m_renderer.draw(m_boards[0], shotsOnly[0], titles[0], m_boards[1], shotsOnly[1], titles[1], status);
+    m_renderer.present(cout);
+    if (m_delayMs > 0)
+        this_thread::sleep_for(chrono::milliseconds(m_delayMs));
+}
+
+void FrameEventSink::placementStarted(const Player& player, int /* nShips */)
+{
+    // A new game: the sink may be reused with other players and boards, so
+    // the sides are worked out again from its first turns
+    for (int side = 0; side < 2; side++)
+    {
+        m_attackers[side] = nullptr;
+        m_defenders[side] = nullptr;
+        m_boards[side] = nullptr;
+    }
+    m_lastShot.clear();
+
+    // A human player prints their own prompts and boards while placing
+    if (player.isHuman())
+        m_renderer.invalidate();
+}
+
+void FrameEventSink::turnStarted(const Player& attacker, const Player& defender,
+    const Board& defenderBoard)
+{
+    int side = (m_attackers[0] == nullptr || m_attackers[0] == &attacker ? 0 : 1);
+    m_attackers[side] = &attacker;
+    m_defenders[side] = &defender;
+    m_boards[side] = &defenderBoard;
+
+    // A human player is prompted below the frame, scrolling it away
+    if (attacker.isHuman())
+    {
+        m_renderer.invalidate();
+        show(attacker.name() + "'s turn.", nullptr);
+    }
+}
+
+void FrameEventSink::shotWasted(const Player& attacker, Point p)
+{
+    show(attacker.name() + " wasted a shot at (" + to_string(p.r) + ',' + to_string(p.c) + ").", nullptr);
+}
+
+void FrameEventSink::shotFired(const Player& attacker, const Board& defenderBoard,
+    Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+    m_lastShot = attacker.name() + " attacked (" + to_string(p.r) + ',' + to_string(p.c) + ") and ";
+    if (shotHit && !shipDestroyed)
+        m_lastShot += "hit something.";
+    else if (!shotHit)
+        m_lastShot += "missed.";
+    else
+        m_lastShot += "destroyed the " + m_game.shipName(shipId) + '.';
+
+    // The winning shot is shown by gameWon
+    if (!defenderBoard.allShipsDestroyed())
+        show(m_lastShot, nullptr);
+}
+
+void FrameEventSink::shipSunk(const Player& /* attacker */, int /* shipId */)
+{
+    // Already reported by shotFired
+}
+
+void FrameEventSink::gameWon(const Player& winner, const Board& loserBoard)
+{
+    show(m_lastShot + "  " + winner.name() + " wins!", &loserBoard);
+}
+
+void FrameEventSink::turnEnded(const Player& /* attacker */)
+{
+}
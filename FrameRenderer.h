@@ -0,0 +1,96 @@
+#ifndef FRAMERENDERER_INCLUDED
+#define FRAMERENDERER_INCLUDED
+
+#include "GameEvents.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class Board;
+class Game;
+class Player;
+
+// Draws both boards of a game side by side, each under a title, with a
+// status line below them.  A frame is laid out in a buffer kept from one
+// frame to the next and sent to the terminal in a single write.
+//
+// PLAIN prints every frame in full after the one before.  ANSI draws the
+// first frame in full and after that moves the cursor to each run of cells
+// that changed and rewrites only those, so a turn costs a few bytes however
+// big the board is.
+class FrameRenderer
+{
+public:
+    enum Mode { PLAIN, ANSI };
+
+    FrameRenderer(const Game& g, Mode mode);
+
+    // Lay out a frame.  A null board leaves its side empty; shotsOnly hides
+    // the ships on a board that haven't been hit, as Board::display does.
+    void draw(const Board* left, bool leftShotsOnly, const std::string& leftTitle,
+        const Board* right, bool rightShotsOnly, const std::string& rightTitle,
+        const std::string& status);
+
+    // Send the last frame drawn to out in one write
+    void present(std::ostream& out);
+
+    // Make the next ANSI frame clear the screen and redraw everything, e.g.
+    // after something else has written to the terminal
+    void invalidate() { m_shownValid = false; }
+
+private:
+    void drawBoard(const Board* b, bool shotsOnly, const std::string& title, int left);
+    void appendMove(int row, int col);      // 0-based frame position
+
+    static constexpr int GAP = 4;           // columns between the two boards
+
+    Mode m_mode;
+    int m_rows, m_cols;
+    int m_labelWidth;                       // of the row labels
+    int m_boardWidth;                       // label, space and cells
+    int m_width, m_height;                  // of the frame above the status line
+
+    std::vector<char> m_frame;              // m_height rows of m_width characters
+    std::string m_status;
+    std::vector<char> m_shown;              // what an ANSI terminal shows now
+    std::string m_shownStatus;
+    bool m_shownValid;
+    std::string m_out;                      // bytes of the next write
+};
+
+// Shows a game as frames: both boards and a line saying what just
+// happened, once per shot.  In ANSI mode each frame replaces the last in
+// place, which suits watching a game between two computer players.  One
+// sink can show any number of games in turn, with any players.
+class FrameEventSink final : public GameEventSink
+{
+public:
+    // delayMs pauses after each frame so a game can be followed
+    FrameEventSink(const Game& g, FrameRenderer::Mode mode, int delayMs);
+
+    void placementStarted(const Player& player, int nShips) override;
+    void turnStarted(const Player& attacker, const Player& defender,
+        const Board& defenderBoard) override;
+    void shotWasted(const Player& attacker, Point p) override;
+    void shotFired(const Player& attacker, const Board& defenderBoard,
+        Point p, bool shotHit, bool shipDestroyed, int shipId) override;
+    void shipSunk(const Player& attacker, int shipId) override;
+    void gameWon(const Player& winner, const Board& loserBoard) override;
+    void turnEnded(const Player& attacker) override;
+
+private:
+    // Draw and present a frame; revealed, if not null, has its ships shown
+    // whoever attacks it
+    void show(const std::string& status, const Board* revealed);
+
+    const Game& m_game;
+    FrameRenderer m_renderer;
+    int m_delayMs;
+    // Side 0 is the player who attacked first, and the board it attacks
+    const Player* m_attackers[2];
+    const Player* m_defenders[2];
+    const Board* m_boards[2];
+    std::string m_lastShot;                 // status line of the latest shot
+};
+
+#endif // FRAMERENDERER_INCLUDED
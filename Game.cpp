@@ -1,13 +1,20 @@
 #include "Game.h"
 #include "Board.h"
 #include "Player.h"
+#include "GameEvents.h"
+#include "GameScheduler.h"
+#include "OpeningBook.h"
+#include "PlacementTable.h"
+#include "Profiler.h"
 #include "globals.h"
-#include "utility.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
 #include <vector>
+#include <utility>
+#include <memory>
+#include <mutex>
 
 using namespace std;
 
@@ -23,9 +30,23 @@ class GameImpl
     };
     vector<Ship*> ships;                    // FVector containing all ships
 
+    uint64_t g_seed;                        // Seed the random generator started from
+    mutable Rng g_rng;                      // Source of every random choice in this game
+    pmr::memory_resource* g_memory;         // Backs the boards and players of this game
+
+    // Built on first use, after which the fleet can no longer change
+    mutable once_flag g_tableBuilt;
+    mutable shared_ptr<const PlacementTable> g_table;
+
+    const OpeningBook* g_book;              // Shots for early positions, or nullptr
+
 public:
-    GameImpl(int nRows, int nCols);
+    GameImpl(int nRows, int nCols, uint64_t seed, pmr::memory_resource* memory);
     ~GameImpl();
+    uint64_t seed() const;
+    void reseed(uint64_t seed);
+    Rng& rng() const;
+    pmr::memory_resource* memory() const;
     int rows() const;
     int cols() const;
     bool isValid(Point p) const;
@@ -35,7 +56,36 @@ public:
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
     string shipName(int shipId) const;
-    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    bool isFrozen() const;
+    const PlacementTable& placementTable() const;
+    void setOpeningBook(const OpeningBook* book);
+    const OpeningBook* openingBook() const;
+    template <class Sink>
+    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, Sink& sink);
+
+    // Where a game stands between two calls to advance
+    struct Progress
+    {
+        enum Stage { PLACING, TURN_STARTING, SHOOTING, OVER };
+
+        Progress(Player* p1, Player* p2, Board& b1, Board& b2)
+            : players{ p1, p2 }, boards{ &b1, &b2 }, stage(PLACING), attacker(0), winner(nullptr)
+        {}
+
+        Player* players[2];                 // the player moving first, and the other
+        Board* boards[2];                   // their boards
+        Stage stage;
+        int attacker;                       // index of the player whose turn it is
+        Player* winner;                     // once OVER; nullptr if ships couldn't be placed
+    };
+
+    struct PhaseClock;
+
+    // Play from where progress stands until the game is over and return
+    // true.  Unless Blocking, stop instead when the attacker has no shot
+    // ready and return false; the attacker calls wake once it has one.
+    template <class Sink, bool Blocking>
+    bool advance(Progress& progress, Sink& sink, PhaseClock* clock, const function<void()>* wake);
 };
 
 void waitForEnter()
@@ -44,7 +94,8 @@ void waitForEnter()
     cin.ignore(10000, '\n');
 }
 
-GameImpl::GameImpl(int nRows, int nCols) : g_rows(nRows), g_cols(nCols), ships()
+GameImpl::GameImpl(int nRows, int nCols, uint64_t seed, pmr::memory_resource* memory)
+    : g_rows(nRows), g_cols(nCols), ships(), g_seed(seed), g_rng(seed), g_memory(memory), g_book(nullptr)
 {}
 
 GameImpl::~GameImpl()
@@ -78,9 +129,31 @@ bool GameImpl::isValid(Point p) const
     return p.r >= 0 && p.r < rows() && p.c >= 0 && p.c < cols();
 }
 
+uint64_t GameImpl::seed() const
+{
+    return g_seed;
+}
+
+void GameImpl::reseed(uint64_t seed)
+{
+    g_seed = seed;
+    g_rng.reseed(seed);
+}
+
+Rng& GameImpl::rng() const
+{
+    return g_rng;
+}
+
+pmr::memory_resource* GameImpl::memory() const
+{
+    return g_memory;
+}
+
 Point GameImpl::randomPoint() const
 {
-    return Point(randInt(rows()), randInt(cols()));
+    int r = g_rng.nextInt(rows());
+    return Point(r, g_rng.nextInt(cols()));
 }
 
 bool GameImpl::addShip(int length, char symbol, string name)
@@ -127,129 +200,279 @@ string GameImpl::shipName(int shipId) const
     return " ";
 }
 
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause = true)
+bool GameImpl::isFrozen() const
 {
-    // Place ships on board
-
-    if (p1->isHuman())
-        cout << p1->name() << " must place " << nShips() << " ships." << endl;
-    if (!p1->placeShips(b1))
-        return nullptr;
-
-    if (p2->isHuman())
-        cout << p2->name() << " must place " << nShips() << " ships." << endl;
-    if (!p2->placeShips(b2))
-        return nullptr;
+    return g_table != nullptr;
+}
 
-    // Game starts
+const PlacementTable& GameImpl::placementTable() const
+{
+    call_once(g_tableBuilt, [this] {
+        vector<int> lengths;
+        for (size_t i = 0; i < ships.size(); i++)
+            lengths.push_back(ships[i]->len);
+        g_table = PlacementTable::get(g_rows, g_cols, lengths);
+    });
+    return *g_table;
+}
 
-    bool validShot = false;
-    bool shotHit = false;
-    bool shipDestroyed = false;
-    int shipId = -1;
+void GameImpl::setOpeningBook(const OpeningBook* book)
+{
+    g_book = book;
+}
 
-    while (true)            // While game hasn't been ended
-    {
-        // First player's turn
+const OpeningBook* GameImpl::openingBook() const
+{
+    return g_book;
+}
 
-        Point p;
-        cout << p1->name() << "'s turn.  Board for " << p2->name() << ':' << endl;
+// Passes every event on to another sink, adding up the time it takes
+template <class Sink>
+class TimedEventSink
+{
+public:
+    explicit TimedEventSink(Sink& sink) : m_sink(sink), m_nanos(0) {}
 
-        // Display second player's board
-        if (p1->isHuman())
-            b2.display(true);
-        else
-            b2.display(false);
+    const uint64_t& nanos() const { return m_nanos; }
 
-        p = p1->recommendAttack();                          // Choose attack position
+    void placementStarted(const Player& player, int nShips)
+    {
+        uint64_t start = Profiler::now();
+        m_sink.placementStarted(player, nShips);
+        m_nanos += Profiler::now() - start;
+    }
+    void turnStarted(const Player& attacker, const Player& defender, const Board& defenderBoard)
+    {
+        uint64_t start = Profiler::now();
+        m_sink.turnStarted(attacker, defender, defenderBoard);
+        m_nanos += Profiler::now() - start;
+    }
+    void shotWasted(const Player& attacker, Point p)
+    {
+        uint64_t start = Profiler::now();
+        m_sink.shotWasted(attacker, p);
+        m_nanos += Profiler::now() - start;
+    }
+    void shotFired(const Player& attacker, const Board& defenderBoard,
+        Point p, bool shotHit, bool shipDestroyed, int shipId)
+    {
+        uint64_t start = Profiler::now();
+        m_sink.shotFired(attacker, defenderBoard, p, shotHit, shipDestroyed, shipId);
+        m_nanos += Profiler::now() - start;
+    }
+    void shipSunk(const Player& attacker, int shipId)
+    {
+        uint64_t start = Profiler::now();
+        m_sink.shipSunk(attacker, shipId);
+        m_nanos += Profiler::now() - start;
+    }
+    void gameWon(const Player& winner, const Board& loserBoard)
+    {
+        uint64_t start = Profiler::now();
+        m_sink.gameWon(winner, loserBoard);
+        m_nanos += Profiler::now() - start;
+    }
+    void turnEnded(const Player& attacker)
+    {
+        uint64_t start = Profiler::now();
+        m_sink.turnEnded(attacker);
+        m_nanos += Profiler::now() - start;
+    }
 
-        // Attack at chosen position and record results
+private:
+    Sink& m_sink;
+    uint64_t m_nanos;
+};
 
-        validShot = b2.attack(p, shotHit, shipDestroyed, shipId);               // Attack and record if attack hit a previously attacked location
+// Splits the time of one game into placing ships, taking turns and
+// reporting events to the sink, which is where the game is rendered
+struct GameImpl::PhaseClock
+{
+    const uint64_t& rendered;               // time spent in the sink so far
+    uint64_t start;
+    uint64_t placedAt;                      // 0 until both fleets are placed
+    uint64_t renderedBeforePlaced;
 
-        p1->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+    explicit PhaseClock(const uint64_t& renderNanos)
+        : rendered(renderNanos), start(Profiler::now()), placedAt(0), renderedBeforePlaced(0)
+    {}
 
-        // If attack hit a previously attacked location
-        if (!validShot)
-            cout << p1->name() << " wasted a shot at (" << p.r << ',' << p.c << ")." << endl;
+    void placed()
+    {
+        placedAt = Profiler::now();
+        renderedBeforePlaced = rendered;
+    }
 
+    void finish()
+    {
+        static const int placement = Profiler::probe("game.placement");
+        static const int turns = Profiler::probe("game.turns");
+        static const int rendering = Profiler::probe("game.rendering");
+        static const int total = Profiler::probe("game.total");
+        uint64_t end = Profiler::now();
+        if (placedAt == 0)
+            Profiler::record(placement, end - start - rendered);
         else
         {
-            // Display results of attack
-
-            if (shotHit && !shipDestroyed)
-                cout << p1->name() << " attacked (" << p.r << ',' << p.c << ") and hit something, resulting in:" << endl;
-            else if (!shotHit)
-                cout << p1->name() << " attacked (" << p.r << ',' << p.c << ") and missed, resulting in:" << endl;
-            else if (shotHit && shipDestroyed)
-                cout << p1->name() << " attacked (" << p.r << ',' << p.c << ") and destroyed the " << shipName(shipId) << ", resulting in:" << endl;
-            if (b2.allShipsDestroyed())
-            {
-                b2.display(false);
-                cout << p1->name() << " wins!" << endl;
-                return p1;
-            }
-            if (p1->isHuman())
-                b2.display(true);
-            else
-                b2.display(false);
+            Profiler::record(placement, placedAt - start - renderedBeforePlaced);
+            Profiler::record(turns, end - placedAt - (rendered - renderedBeforePlaced));
         }
+        Profiler::record(rendering, rendered);
+        Profiler::record(total, end - start);
+    }
+};
+
+template <class Sink>
+Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, Sink& sink)
+{
+    Progress progress(p1, p2, b1, b2);
+    if (!Profiler::enabled())
+    {
+        advance<Sink, true>(progress, sink, nullptr, nullptr);
+        return progress.winner;
+    }
+
+    TimedEventSink<Sink> timed(sink);
+    PhaseClock clock(timed.nanos());
+    advance<TimedEventSink<Sink>, true>(progress, timed, &clock, nullptr);
+    clock.finish();
+    return progress.winner;
+}
+
+template <class Sink, bool Blocking>
+bool GameImpl::advance(Progress& progress, Sink& sink, PhaseClock* clock, const function<void()>* wake)
+{
+    Player** players = progress.players;
+    Board** boards = progress.boards;
 
+    if (progress.stage == Progress::PLACING)
+    {
+        // Place ships on board.  Placement is never split: a player placing
+        // its ships holds the thread until it is done.
 
-        // If applicable, pause game until user hits enter
-        if (shouldPause)
+        progress.stage = Progress::OVER;
+        for (int side = 0; side < 2; side++)
         {
-            waitForEnter();
+            sink.placementStarted(*players[side], nShips());
+            if (!players[side]->placeShips(*boards[side]))
+                return true;
         }
 
-        // Second player's turn
+        if (clock != nullptr)
+            clock->placed();
+        progress.stage = Progress::TURN_STARTING;
+    }
 
-        cout << p2->name() << "'s turn.  Board for " << p1->name() << ':' << endl;
-        if (p2->isHuman())
-            b1.display(true);
-        else
-            b1.display(false);
+    // Game starts
 
-        p = p2->recommendAttack();                          // Choose attack position
+    bool validShot = false;
+    bool shotHit = false;
+    bool shipDestroyed = false;
+    int shipId = -1;
 
-        // Attack at chosen position and record results
+    while (progress.stage != Progress::OVER)    // While game hasn't been ended
+    {
+        Player* attacker = players[progress.attacker];
+        Player* defender = players[1 - progress.attacker];
+        Board* target = boards[1 - progress.attacker];      // Board of the player being attacked
+
+        if (progress.stage == Progress::TURN_STARTING)
+        {
+            sink.turnStarted(*attacker, *defender, *target);
+            progress.stage = Progress::SHOOTING;
+        }
+
+        // Choose attack position
+        Point p;
+        if constexpr (Blocking)
+            p = attacker->recommendAttack();
+        else if (!attacker->tryAttack(p, *wake))
+            return false;
 
-        validShot = b1.attack(p, shotHit, shipDestroyed, shipId);                   // Attack and record if attack hits a previously attacked location
-        p2->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+        // Attack at chosen position and record results
 
+        validShot = target->attack(p, shotHit, shipDestroyed, shipId);     // Attack and record if attack hit a previously attacked location
+        attacker->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
 
         // If attack hit a previously attacked location
         if (!validShot)
-            cout << p2->name() << " wasted a shot at (" << p.r << ',' << p.c << ")." << endl;
-
+            sink.shotWasted(*attacker, p);
         else
         {
-            // Display results of attack
-
-            if (shotHit && !shipDestroyed)
-                cout << p2->name() << " attacked (" << p.r << ',' << p.c << ") and hit something, resulting in:" << endl;
-            else if (!shotHit)
-                cout << p2->name() << " attacked (" << p.r << ',' << p.c << ") and missed, resulting in:" << endl;
-            else if (shotHit && shipDestroyed)
-                cout << p2->name() << " attacked (" << p.r << ',' << p.c << ") and destroyed the " << shipName(shipId) << ", resulting in:" << endl;
-            if (b1.allShipsDestroyed())
+            sink.shotFired(*attacker, *target, p, shotHit, shipDestroyed, shipId);
+            if (shotHit && shipDestroyed)
+                sink.shipSunk(*attacker, shipId);
+            if (target->allShipsDestroyed())
             {
-                b1.display(false);
-                cout << p2->name() << " wins!" << endl;
-                return p2;
+                sink.gameWon(*attacker, *target);
+                progress.winner = attacker;
+                progress.stage = Progress::OVER;
+                return true;
             }
-            if (p2->isHuman())
-                b1.display(true);
-            else
-                b1.display(false);
         }
 
-        // If applicable, pause game until user hits enter
-        if (shouldPause)
-            waitForEnter();
-
+        sink.turnEnded(*attacker);
 
+        // Other player's turn
+        progress.attacker = 1 - progress.attacker;
+        progress.stage = Progress::TURN_STARTING;
     }
+    return true;
+}
+
+//******************** ConsoleEventSink functions ********************
+
+void ConsoleEventSink::placementStarted(const Player& player, int nShips)
+{
+    if (player.isHuman())
+        cout << player.name() << " must place " << nShips << " ships." << endl;
+}
+
+void ConsoleEventSink::turnStarted(const Player& attacker, const Player& defender,
+    const Board& defenderBoard)
+{
+    cout << attacker.name() << "'s turn.  Board for " << defender.name() << ':' << endl;
+    defenderBoard.display(attacker.isHuman());
+}
+
+void ConsoleEventSink::shotWasted(const Player& attacker, Point p)
+{
+    cout << attacker.name() << " wasted a shot at (" << p.r << ',' << p.c << ")." << endl;
+}
+
+void ConsoleEventSink::shotFired(const Player& attacker, const Board& defenderBoard,
+    Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+    // Display results of attack
+
+    if (shotHit && !shipDestroyed)
+        cout << attacker.name() << " attacked (" << p.r << ',' << p.c << ") and hit something, resulting in:" << endl;
+    else if (!shotHit)
+        cout << attacker.name() << " attacked (" << p.r << ',' << p.c << ") and missed, resulting in:" << endl;
+    else
+        cout << attacker.name() << " attacked (" << p.r << ',' << p.c << ") and destroyed the " << m_game.shipName(shipId) << ", resulting in:" << endl;
+
+    // The winning board is shown in full by gameWon instead
+    if (!defenderBoard.allShipsDestroyed())
+        defenderBoard.display(attacker.isHuman());
+}
+
+void ConsoleEventSink::shipSunk(const Player& /* attacker */, int /* shipId */)
+{
+    // Already reported by shotFired
+}
+
+void ConsoleEventSink::gameWon(const Player& winner, const Board& loserBoard)
+{
+    loserBoard.display(false);
+    cout << winner.name() << " wins!" << endl;
+}
+
+void ConsoleEventSink::turnEnded(const Player& /* attacker */)
+{
+    // If applicable, pause game until user hits enter
+    if (m_shouldPause)
+        waitForEnter();
 }
 
 //******************** Game functions *******************************
@@ -258,6 +481,14 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
 // You probably don't want to change any of the code from this point down.
 
 Game::Game(int nRows, int nCols)
+    : Game(nRows, nCols, Rng::randomSeed())
+{}
+
+Game::Game(int nRows, int nCols, uint64_t seed)
+    : Game(nRows, nCols, seed, pmr::get_default_resource())
+{}
+
+Game::Game(int nRows, int nCols, uint64_t seed, pmr::memory_resource* memory)
 {
     if (nRows < 1 || nRows > MAXROWS)
     {
@@ -269,7 +500,7 @@ Game::Game(int nRows, int nCols)
         cout << "Number of columns must be >= 1 and <= " << MAXCOLS << endl;
         exit(1);
     }
-    m_impl = new GameImpl(nRows, nCols);
+    m_impl = new GameImpl(nRows, nCols, seed, memory);
 }
 
 Game::~Game()
@@ -292,6 +523,26 @@ bool Game::isValid(Point p) const
     return m_impl->isValid(p);
 }
 
+uint64_t Game::seed() const
+{
+    return m_impl->seed();
+}
+
+void Game::reseed(uint64_t seed)
+{
+    m_impl->reseed(seed);
+}
+
+Rng& Game::rng() const
+{
+    return m_impl->rng();
+}
+
+pmr::memory_resource* Game::memory() const
+{
+    return m_impl->memory();
+}
+
 Point Game::randomPoint() const
 {
     return m_impl->randomPoint();
@@ -299,6 +550,11 @@ Point Game::randomPoint() const
 
 bool Game::addShip(int length, char symbol, string name)
 {
+    if (m_impl->isFrozen())
+    {
+        cout << "Ships can't be added once boards or players use the game" << endl;
+        return false;
+    }
     if (length < 1)
     {
         cout << "Bad ship length " << length << "; it must be >= 1" << endl;
@@ -364,12 +620,123 @@ string Game::shipName(int shipId) const
     return m_impl->shipName(shipId);
 }
 
+const PlacementTable& Game::placementTable() const
+{
+    return m_impl->placementTable();
+}
+
+bool Game::setOpeningBook(const OpeningBook* book)
+{
+    if (book != nullptr && !book->matches(*this))
+    {
+        m_impl->setOpeningBook(nullptr);
+        return false;
+    }
+    m_impl->setOpeningBook(book);
+    return true;
+}
+
+const OpeningBook* Game::openingBook() const
+{
+    return m_impl->openingBook();
+}
+
 Player* Game::play(Player* p1, Player* p2, bool shouldPause)
+{
+    ConsoleEventSink sink(*this, shouldPause);
+    if (p1 == nullptr || p2 == nullptr || nShips() == 0)
+        return nullptr;
+    Board b1(*this);
+    Board b2(*this);
+    return m_impl->play(p1, p2, b1, b2, sink);
+}
+
+Player* Game::play(Player* p1, Player* p2, GameEventSink& sink)
+{
+    if (p1 == nullptr || p2 == nullptr || nShips() == 0)
+        return nullptr;
+    Board b1(*this);
+    Board b2(*this);
+    return m_impl->play(p1, p2, b1, b2, sink);
+}
+
+Player* Game::play(Player* p1, Player* p2, NullEventSink& sink)
 {
     if (p1 == nullptr || p2 == nullptr || nShips() == 0)
         return nullptr;
     Board b1(*this);
     Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+    return m_impl->play(p1, p2, b1, b2, sink);
+}
+
+Player* Game::play(Player* p1, Player* p2, Board& b1, Board& b2, GameEventSink& sink)
+{
+    if (p1 == nullptr || p2 == nullptr || nShips() == 0 || &b1 == &b2)
+        return nullptr;
+    b1.reset();
+    b2.reset();
+    return m_impl->play(p1, p2, b1, b2, sink);
+}
+
+Player* Game::play(Player* p1, Player* p2, Board& b1, Board& b2, NullEventSink& sink)
+{
+    if (p1 == nullptr || p2 == nullptr || nShips() == 0 || &b1 == &b2)
+        return nullptr;
+    b1.reset();
+    b2.reset();
+    return m_impl->play(p1, p2, b1, b2, sink);
 }
 
+
+//******************** GameTask functions ****************************
+
+struct GameTask::State
+{
+    State(Player* p1, Player* p2, Board& b1, Board& b2, GameEventSink& s)
+        : progress(p1, p2, b1, b2), sink(&s)
+    {}
+
+    GameImpl::Progress progress;
+    GameEventSink* sink;
+};
+
+GameTask::GameTask(const Game& g)
+    : m_game(g)
+{}
+
+GameTask::~GameTask()
+{}
+
+bool GameTask::start(Player* p1, Player* p2, Board& b1, Board& b2, GameEventSink& sink)
+{
+    // A task playing game after game keeps its state
+    if (m_state)
+        *m_state = State(p1, p2, b1, b2, sink);
+    else
+        m_state.reset(new State(p1, p2, b1, b2, sink));
+    if (p1 == nullptr || p2 == nullptr || m_game.nShips() == 0 || &b1 == &b2)
+    {
+        m_state->progress.stage = GameImpl::Progress::OVER;
+        return false;
+    }
+    b1.reset();
+    b2.reset();
+    return true;
+}
+
+bool GameTask::resume(const function<void()>& wake)
+{
+    if (!m_state)
+        return true;
+    return m_game.m_impl->advance<GameEventSink, false>(m_state->progress, *m_state->sink, nullptr, &wake);
+}
+
+bool GameTask::finished() const
+{
+    return !m_state || m_state->progress.stage == GameImpl::Progress::OVER;
+}
+
+Player* GameTask::winner() const
+{
+    return m_state ? m_state->progress.winner : nullptr;
+}
@@ -3,16 +3,32 @@
 
 #include <string>
 #include <cassert>
+#include <cstdint>
+#include <memory_resource>
 
 class Point;
+class Board;
+class Rng;
 class Player;
 class GameImpl;
+class PlacementTable;
+class OpeningBook;
+class GameEventSink;
+class NullEventSink;
 
 class Game
 {
 public:
-    Game(int nRows, int nCols);
+    Game(int nRows, int nCols);                     // Seeded from the system's entropy source
+    Game(int nRows, int nCols, uint64_t seed);
+    // Boards and players of this game, and everything inside them, are
+    // allocated from memory, which must outlive them
+    Game(int nRows, int nCols, uint64_t seed, std::pmr::memory_resource* memory);
     ~Game();
+    uint64_t seed() const;
+    void reseed(uint64_t seed);                     // Restart the random sequence from seed
+    Rng& rng() const;                               // Random source for the board and players
+    std::pmr::memory_resource* memory() const;      // Where boards and players allocate
     int rows() const;
     int cols() const;
     bool isValid(Point p) const;
@@ -22,12 +38,28 @@ public:
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
     std::string shipName(int shipId) const;
-    Player* play(Player* p1, Player* p2, bool shouldPause = true);
+    // Every placement of every ship, shared with other games of the same
+    // size and fleet.  The first call freezes the fleet: addShip fails after it.
+    const PlacementTable& placementTable() const;
+    // Opening book the players may take their early shots from, or nullptr
+    // for none.  Fails, leaving no book, if the book was built for another
+    // size or fleet.  The book must outlive the game.
+    bool setOpeningBook(const OpeningBook* book);
+    const OpeningBook* openingBook() const;
+    Player* play(Player* p1, Player* p2, bool shouldPause = true);    // Print the game to cout
+    Player* play(Player* p1, Player* p2, GameEventSink& sink);        // Report the game to sink
+    Player* play(Player* p1, Player* p2, NullEventSink& sink);        // Play without any output
+    // Play on boards the caller owns, which must have been built for this
+    // game.  They are reset before the ships are placed; the players are not.
+    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, GameEventSink& sink);
+    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, NullEventSink& sink);
     // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
 
 private:
+    friend class GameTask;              // plays games a piece at a time
+
     GameImpl* m_impl;
 };
 
@@ -0,0 +1,72 @@
+#ifndef GAMEEVENTS_INCLUDED
+#define GAMEEVENTS_INCLUDED
+
+#include "globals.h"
+
+class Board;
+class Game;
+class Player;
+
+// Receives what happens during Game::play.  The game itself never prints;
+// everything the user sees comes from a sink.
+class GameEventSink
+{
+public:
+    virtual ~GameEventSink() {}
+
+    // A player is about to place their ships
+    virtual void placementStarted(const Player& player, int nShips) = 0;
+    // attacker is about to choose a shot at defender's board
+    virtual void turnStarted(const Player& attacker, const Player& defender,
+        const Board& defenderBoard) = 0;
+    // attacker chose a point off the board or one already attacked
+    virtual void shotWasted(const Player& attacker, Point p) = 0;
+    // attacker's shot at p was resolved on defenderBoard
+    virtual void shotFired(const Player& attacker, const Board& defenderBoard,
+        Point p, bool shotHit, bool shipDestroyed, int shipId) = 0;
+    // attacker's last shot destroyed ship shipId
+    virtual void shipSunk(const Player& attacker, int shipId) = 0;
+    // winner destroyed every ship on loserBoard
+    virtual void gameWon(const Player& winner, const Board& loserBoard) = 0;
+    // attacker's turn is over and the game goes on
+    virtual void turnEnded(const Player& attacker) = 0;
+};
+
+// Ignores every event.  Game::play has an overload taking this type
+// directly, so the calls are resolved statically and vanish entirely.
+class NullEventSink final : public GameEventSink
+{
+public:
+    void placementStarted(const Player&, int) override {}
+    void turnStarted(const Player&, const Player&, const Board&) override {}
+    void shotWasted(const Player&, Point) override {}
+    void shotFired(const Player&, const Board&, Point, bool, bool, int) override {}
+    void shipSunk(const Player&, int) override {}
+    void gameWon(const Player&, const Board&) override {}
+    void turnEnded(const Player&) override {}
+};
+
+// Prints the game to cout, optionally waiting for enter after each turn
+class ConsoleEventSink final : public GameEventSink
+{
+public:
+    ConsoleEventSink(const Game& g, bool shouldPause)
+        : m_game(g), m_shouldPause(shouldPause)
+    {}
+
+    void placementStarted(const Player& player, int nShips) override;
+    void turnStarted(const Player& attacker, const Player& defender,
+        const Board& defenderBoard) override;
+    void shotWasted(const Player& attacker, Point p) override;
+    void shotFired(const Player& attacker, const Board& defenderBoard,
+        Point p, bool shotHit, bool shipDestroyed, int shipId) override;
+    void shipSunk(const Player& attacker, int shipId) override;
+    void gameWon(const Player& winner, const Board& loserBoard) override;
+    void turnEnded(const Player& attacker) override;
+
+private:
+    const Game& m_game;
+    bool m_shouldPause;
+};
+
+#endif // GAMEEVENTS_INCLUDED
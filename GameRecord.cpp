@@ -0,0 +1,264 @@
+#include "GameRecord.h"
+#include "Board.h"
+#include "Game.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[4] = { 'B', 'S', 'G', 'R' };
+    const uint16_t VERSION = 1;
+
+    // Records are handed to the writer once this much has accumulated
+    const size_t BLOCK_BYTES = 1 << 20;
+
+    using BinaryFile::padded;
+    using BinaryFile::put;
+    using BinaryFile::get;
+
+    // Bytes in a record holding nShots shots
+    size_t recordBytes(int nShips, int cellBytes, size_t nShots)
+    {
+        return padded(sizeof(GameRecordEntry) + 2 * nShips * (cellBytes + 1) + nShots * (cellBytes + 1));
+    }
+}
+
+int GameRecordInfo::cellBytes() const
+{
+    // The all-ones value must stay free to mean "no cell"
+    long long cells = static_cast<long long>(rows) * cols;
+    if (cells <= 0xFF)
+        return 1;
+    if (cells <= 0xFFFF)
+        return 2;
+    return 4;
+}
+
+//******************** GameRecordWriter functions ********************
+
+GameRecordWriter::GameRecordWriter(const string& path, const GameRecordInfo& info)
+    : m_info(info), m_fd(-1), m_end(0), m_failed(false)
+{
+    // magic, version, header bytes, rows, cols, ships, cell bytes, lengths,
+    // then each player type as a length byte and its characters
+    vector<char> header(MAGIC, MAGIC + sizeof(MAGIC));
+    put<uint16_t>(header, VERSION);
+    put<uint32_t>(header, 0);                           // filled in below
+    put<uint16_t>(header, static_cast<uint16_t>(info.rows));
+    put<uint16_t>(header, static_cast<uint16_t>(info.cols));
+    put<uint16_t>(header, static_cast<uint16_t>(info.fleet.size()));
+    put<uint8_t>(header, static_cast<uint8_t>(info.cellBytes()));
+    for (size_t k = 0; k < info.fleet.size(); k++)
+        put<uint16_t>(header, static_cast<uint16_t>(info.fleet[k]));
+    for (int side = 0; side < 2; side++)
+    {
+        string type = info.type[side].substr(0, 255);
+        put<uint8_t>(header, static_cast<uint8_t>(type.size()));
+        header.insert(header.end(), type.begin(), type.end());
+    }
+    header.resize(padded(header.size()), 0);
+    uint32_t headerBytes = static_cast<uint32_t>(header.size());
+    memcpy(&header[sizeof(MAGIC) + sizeof(VERSION)], &headerBytes, sizeof(headerBytes));
+
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0)
+        return;
+    append(header.data(), header.size());
+}
+
+GameRecordWriter::~GameRecordWriter()
+{
+    if (m_fd >= 0)
+        ::close(m_fd);
+}
+
+void GameRecordWriter::append(const char* data, size_t n)
+{
+    if (m_fd < 0 || n == 0)
+        return;
+
+    // Claim the range first; writes to disjoint ranges need no ordering
+    off_t offset = static_cast<off_t>(m_end.fetch_add(n));
+    while (n > 0)
+    {
+        ssize_t written = ::pwrite(m_fd, data, n, offset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            m_failed = true;
+            return;
+        }
+        data += written;
+        n -= written;
+        offset += written;
+    }
+}
+
+//******************** GameRecorder functions *************************
+
+GameRecorder::GameRecorder(GameRecordWriter& out, const Game& g)
+    : m_out(out), m_game(g), m_cellBytes(out.info().cellBytes()), m_entry()
+{
+    m_buffer.reserve(BLOCK_BYTES + recordBytes(g.nShips(), m_cellBytes, 2 * g.rows() * g.cols()));
+}
+
+GameRecorder::~GameRecorder()
+{
+    flush();
+}
+
+void GameRecorder::startGame(uint32_t game, int firstSide)
+{
+    m_entry = GameRecordEntry();
+    m_entry.seed = m_game.seed();
+    m_entry.game = game;
+    m_entry.firstSide = static_cast<uint8_t>(firstSide);
+    m_shotCells.clear();
+    m_shotResults.clear();
+}
+
+void GameRecorder::putCell(uint32_t cell)
+{
+    const char* p = reinterpret_cast<const char*>(&cell);
+    m_buffer.insert(m_buffer.end(), p, p + m_cellBytes);
+}
+
+void GameRecorder::endGame(const Board& side0, const Board& side1, int winnerSide)
+{
+    const uint32_t noCell = (m_cellBytes == 4 ? 0xFFFFFFFF : (1u << (8 * m_cellBytes)) - 1);
+    size_t start = m_buffer.size();
+
+    m_entry.nShots = static_cast<uint32_t>(m_shotCells.size());
+    m_entry.size = static_cast<uint32_t>(recordBytes(m_game.nShips(), m_cellBytes, m_shotCells.size()));
+    m_entry.winner = (winnerSide < 0 ? GameRecordEntry::NO_WINNER : static_cast<uint8_t>(winnerSide));
+    put(m_buffer, m_entry);
+
+    const Board* boards[2] = { &side0, &side1 };
+    for (int side = 0; side < 2; side++)
+    {
+        for (int shipId = 0; shipId < m_game.nShips(); shipId++)
+        {
+            Point topOrLeft;
+            Direction dir = HORIZONTAL;
+            if (boards[side]->shipPlacement(shipId, topOrLeft, dir))
+                putCell(topOrLeft.r * m_game.cols() + topOrLeft.c);
+            else
+                putCell(noCell);
+            put<uint8_t>(m_buffer, static_cast<uint8_t>(dir));
+        }
+    }
+
+    for (size_t k = 0; k < m_shotCells.size(); k++)
+        putCell(m_shotCells[k] == UINT32_MAX ? noCell : m_shotCells[k]);
+    m_buffer.insert(m_buffer.end(), m_shotResults.begin(), m_shotResults.end());
+    m_buffer.resize(start + m_entry.size, 0);
+
+    if (m_buffer.size() >= BLOCK_BYTES)
+        flush();
+}
+
+void GameRecorder::flush()
+{
+    m_out.append(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+}
+
+void GameRecorder::addShot(Point p, ShotResult result)
+{
+    m_shotCells.push_back(m_game.isValid(p) ? p.r * m_game.cols() + p.c : UINT32_MAX);
+    m_shotResults.push_back(static_cast<uint8_t>(result));
+}
+
+void GameRecorder::shotWasted(const Player& /* attacker */, Point p)
+{
+    addShot(p, SHOT_WASTED);
+}
+
+void GameRecorder::shotFired(const Player& /* attacker */, const Board& /* defenderBoard */,
+    Point p, bool shotHit, bool shipDestroyed, int /* shipId */)
+{
+    addShot(p, !shotHit ? SHOT_MISS : (shipDestroyed ? SHOT_SUNK : SHOT_HIT));
+}
+
+//******************** GameRecordReader functions ********************
+
+GameRecordReader::GameRecordReader(const string& path)
+    : m_file(path, MappedFile::SEQUENTIAL), m_end(m_file.end()), m_first(nullptr), m_cellBytes(1),
+      m_placementBytes(0), m_noCell(0)
+{
+    if (m_file.isOpen() && !readHeader())
+    {
+        m_file.close();
+        m_end = nullptr;
+    }
+}
+
+bool GameRecordReader::readHeader()
+{
+    const char* p = m_file.begin();
+    char magic[sizeof(MAGIC)];
+    uint16_t version, rows, cols, nShips;
+    uint32_t headerBytes;
+    uint8_t cellBytes;
+    if (!get(p, m_end, magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        !get(p, m_end, version) || version != VERSION ||
+        !get(p, m_end, headerBytes) || headerBytes % 8 != 0 || headerBytes > m_file.size() ||
+        !get(p, m_end, rows) || !get(p, m_end, cols) || !get(p, m_end, nShips) ||
+        !get(p, m_end, cellBytes))
+        return false;
+
+    m_info.rows = rows;
+    m_info.cols = cols;
+    m_info.fleet.resize(nShips);
+    for (int k = 0; k < nShips; k++)
+    {
+        uint16_t len;
+        if (!get(p, m_end, len))
+            return false;
+        m_info.fleet[k] = len;
+    }
+    for (int side = 0; side < 2; side++)
+    {
+        uint8_t len;
+        if (!get(p, m_end, len) || m_end - p < len)
+            return false;
+        m_info.type[side].assign(p, len);
+        p += len;
+    }
+    if (cellBytes != m_info.cellBytes() || p > m_file.begin() + headerBytes)
+        return false;
+
+    m_cellBytes = cellBytes;
+    m_placementBytes = nShips * (cellBytes + 1);
+    m_noCell = (cellBytes == 4 ? 0xFFFFFFFF : (1u << (8 * cellBytes)) - 1);
+    m_first = m_file.begin() + headerBytes;
+    return true;
+}
+
+const char* GameRecordReader::check(const char* p) const
+{
+    // A record cut short, or a hole left by a writer that never finished,
+    // ends the file
+    if (p == nullptr || m_end - p < static_cast<ptrdiff_t>(sizeof(GameRecordEntry)))
+        return m_end;
+    const GameRecordEntry* e = reinterpret_cast<const GameRecordEntry*>(p);
+    size_t expected = recordBytes(static_cast<int>(m_info.fleet.size()), m_cellBytes, e->nShots);
+    if (e->size != expected || static_cast<size_t>(m_end - p) < expected)
+        return m_end;
+    return p;
+}
+
+bool GameRecordReader::Record::placement(int side, int shipId, Point& topOrLeft, Direction& dir) const
+{
+    const unsigned char* p = placements() + side * m_file->m_placementBytes + shipId * (m_file->m_cellBytes + 1);
+    uint32_t cell = readCell(p);
+    if (cell == m_file->m_noCell)
+        return false;
+    topOrLeft = Point(cell / m_file->m_info.cols, cell % m_file->m_info.cols);
+    dir = static_cast<Direction>(p[m_file->m_cellBytes]);
+    return true;
+}
@@ -0,0 +1,230 @@
+#ifndef GAMERECORD_INCLUDED
+#define GAMERECORD_INCLUDED
+
+#include "BinaryFile.h"
+#include "GameEvents.h"
+#include "globals.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class Board;
+class Game;
+
+// Binary log of complete games, for keeping every game of a tournament.
+//
+// A file starts with a header describing what all its games share: the
+// board size, the fleet, the two player types and the width of a cell
+// index.  Cells are numbered r * cols + c and stored in 1 byte on boards
+// of up to 255 cells, otherwise in 2 or 4; the all-ones value stands
+// for a point off the board or a ship that was never placed.  Every game
+// that follows is one record:
+//
+//   GameRecordEntry                     seed, game number, sides, sizes
+//   placements[2][nShips]               origin cell, then direction byte
+//   shot cells[nShots]                  attackers alternate, first side first
+//   shot results[nShots]                one ShotResult byte each
+//   padding to a multiple of 8 bytes
+//
+// Side 0 and side 1 are the first and second player type in the header,
+// whichever of them moved first.  Everything is in the byte order of the
+// machine that wrote the file.  Records may appear in any order.
+
+enum ShotResult {
+    SHOT_MISS, SHOT_HIT, SHOT_SUNK, SHOT_WASTED
+};
+
+// What every game in a record file has in common
+struct GameRecordInfo
+{
+    int rows = 0;
+    int cols = 0;
+    std::vector<int> fleet;             // ship lengths, by shipId
+    std::string type[2];                // player type of each side, as given to createPlayer
+
+    // Bytes in a stored cell index for this board size
+    int cellBytes() const;
+};
+
+// Fixed part at the start of every record
+struct GameRecordEntry
+{
+    uint64_t seed;                      // the game's seed, as passed to Game::reseed
+    uint32_t game;                      // number of the game within its run
+    uint32_t nShots;
+    uint32_t size;                      // bytes in the whole record, padding included
+    uint8_t firstSide;                  // side that attacked first
+    uint8_t winner;                     // winning side, or NO_WINNER
+    uint16_t reserved;
+
+    static const uint8_t NO_WINNER = 0xFF;
+};
+
+// Appends records to a new file.  Threads write disjoint byte ranges
+// reserved with a single atomic add, so appending never takes a lock.
+class GameRecordWriter
+{
+public:
+    // Creates path, replacing any existing file, and writes the header.
+    // Check isOpen() before use.
+    GameRecordWriter(const std::string& path, const GameRecordInfo& info);
+    ~GameRecordWriter();
+
+    bool isOpen() const { return m_fd >= 0; }
+    bool ok() const { return isOpen() && !m_failed; }    // false once a write has failed
+    const GameRecordInfo& info() const { return m_info; }
+
+    // Write n bytes of whole records.  Safe to call from many threads at once.
+    void append(const char* data, size_t n);
+
+    GameRecordWriter(const GameRecordWriter&) = delete;
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+private:
+    GameRecordInfo m_info;
+    int m_fd;
+    std::atomic<uint64_t> m_end;        // file offset of the next byte to reserve
+    std::atomic<bool> m_failed;
+};
+
+// Records the games one thread plays, by listening to Game::play.  Records
+// are collected in a buffer and handed to the writer a block at a time.
+//
+//   recorder.startGame(k, firstSide);
+//   winner = g.play(first, second, firstBoard, secondBoard, recorder);
+//   recorder.endGame(side0Board, side1Board, winnerSide);
+class GameRecorder final : public GameEventSink
+{
+public:
+    GameRecorder(GameRecordWriter& out, const Game& g);
+    ~GameRecorder();                    // flushes
+
+    // Begin a game played with the game's current seed
+    void startGame(uint32_t game, int firstSide);
+    // Add the game just played to the buffer.  winnerSide is -1 if nobody won.
+    void endGame(const Board& side0, const Board& side1, int winnerSide);
+    // Hand everything buffered to the writer
+    void flush();
+
+    void placementStarted(const Player&, int) override {}
+    void turnStarted(const Player&, const Player&, const Board&) override {}
+    void shotWasted(const Player& attacker, Point p) override;
+    void shotFired(const Player& attacker, const Board& defenderBoard,
+        Point p, bool shotHit, bool shipDestroyed, int shipId) override;
+    void shipSunk(const Player&, int) override {}
+    void gameWon(const Player&, const Board&) override {}
+    void turnEnded(const Player&) override {}
+
+private:
+    void addShot(Point p, ShotResult result);
+    void putCell(uint32_t cell);
+
+    GameRecordWriter& m_out;
+    const Game& m_game;
+    int m_cellBytes;
+    GameRecordEntry m_entry;
+    std::vector<uint32_t> m_shotCells;  // the game in progress
+    std::vector<uint8_t> m_shotResults;
+    std::vector<char> m_buffer;         // finished records not yet written
+};
+
+// Maps a record file into memory and walks its records in place, without
+// copying or decoding anything up front.
+//
+//   GameRecordReader in(path);
+//   for (const GameRecordReader::Record& rec : in)
+//       for (int k = 0; k < rec.nShots(); k++)
+//           ... rec.shotCell(k), rec.shotResult(k) ...
+class GameRecordReader
+{
+public:
+    explicit GameRecordReader(const std::string& path);
+
+    bool isOpen() const { return m_file.isOpen(); }
+    const GameRecordInfo& info() const { return m_info; }
+    uint32_t noCell() const { return m_noCell; }       // stored cell meaning "none"
+
+    // One game, viewed directly in the mapped file
+    class Record
+    {
+    public:
+        const GameRecordEntry& entry() const { return *reinterpret_cast<const GameRecordEntry*>(m_data); }
+        uint64_t seed() const { return entry().seed; }
+        uint32_t game() const { return entry().game; }
+        int firstSide() const { return entry().firstSide; }
+        int winner() const { return entry().winner == GameRecordEntry::NO_WINNER ? -1 : entry().winner; }
+        int nShots() const { return static_cast<int>(entry().nShots); }
+
+        int attacker(int k) const { return (firstSide() + k) % 2; }     // side that fired shot k
+        uint32_t shotCell(int k) const { return readCell(shotCells() + k * m_file->m_cellBytes); }
+        ShotResult shotResult(int k) const { return static_cast<ShotResult>(shotCells()[nShots() * m_file->m_cellBytes + k]); }
+
+        // Where side placed ship shipId; false if it never did
+        bool placement(int side, int shipId, Point& topOrLeft, Direction& dir) const;
+
+    private:
+        friend class GameRecordReader;
+        Record(const char* data, const GameRecordReader* file) : m_data(data), m_file(file) {}
+
+        const unsigned char* placements() const { return reinterpret_cast<const unsigned char*>(m_data + sizeof(GameRecordEntry)); }
+        const unsigned char* shotCells() const { return placements() + 2 * m_file->m_placementBytes; }
+        uint32_t readCell(const unsigned char* p) const
+        {
+            switch (m_file->m_cellBytes)
+            {
+              case 1:  return *p;
+              case 2:  { uint16_t v; std::memcpy(&v, p, 2); return v; }
+              default: { uint32_t v; std::memcpy(&v, p, 4); return v; }
+            }
+        }
+
+        const char* m_data;
+        const GameRecordReader* m_file;
+    };
+
+    class const_iterator
+    {
+    public:
+        const Record& operator*() const { return m_record; }
+        const Record* operator->() const { return &m_record; }
+        const_iterator& operator++()
+        {
+            m_record.m_data = m_record.m_file->next(m_record.m_data);
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return m_record.m_data == other.m_record.m_data; }
+        bool operator!=(const const_iterator& other) const { return m_record.m_data != other.m_record.m_data; }
+
+    private:
+        friend class GameRecordReader;
+        const_iterator(const char* data, const GameRecordReader* file) : m_record(data, file) {}
+        Record m_record;
+    };
+
+    // Iteration stops early at a truncated or unfinished record
+    const_iterator begin() const { return const_iterator(check(m_first), this); }
+    const_iterator end() const { return const_iterator(m_end, this); }
+
+    GameRecordReader(const GameRecordReader&) = delete;
+    GameRecordReader& operator=(const GameRecordReader&) = delete;
+
+private:
+    bool readHeader();
+    const char* check(const char* p) const;     // p if a whole record starts there, else m_end
+    const char* next(const char* p) const
+    {
+        return check(p + reinterpret_cast<const GameRecordEntry*>(p)->size);
+    }
+
+    GameRecordInfo m_info;
+    MappedFile m_file;
+    const char* m_end;                  // of the mapped file
+    const char* m_first;                // first record
+    int m_cellBytes;
+    int m_placementBytes;               // placements of one side
+    uint32_t m_noCell;
+};
+
+#endif // GAMERECORD_INCLUDED
@@ -0,0 +1,82 @@
+#include "GameScheduler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+using namespace std;
+
+GameScheduler::GameScheduler(ThreadPool& pool)
+    : m_pool(pool), m_unfinished(0)
+{}
+
+void GameScheduler::add(ResumableTask* task)
+{
+    unique_ptr<Entry> entry(new Entry);
+    entry->task = task;
+    entry->state = Entry::QUEUED;
+    entry->woken = false;
+    Entry* e = entry.get();
+    entry->wake = [this, e] { wake(e); };
+
+    lock_guard<mutex> lock(m_mutex);
+    m_ready.push_back(e);
+    m_entries.push_back(move(entry));
+    ++m_unfinished;
+}
+
+void GameScheduler::run(int maxThreads)
+{
+    int nThreads = m_pool.size() + 1;
+    if (maxThreads > 0)
+        nThreads = min(nThreads, maxThreads);
+
+    // Each loop runs until every task is done, so loops the pool can't
+    // start right away find nothing left to do
+    m_pool.parallelFor(nThreads, [this](int) { workerLoop(); }, nThreads);
+}
+
+void GameScheduler::workerLoop()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (true)
+    {
+        m_changed.wait(lock, [this] { return !m_ready.empty() || m_unfinished == 0; });
+        if (m_ready.empty())
+            return;
+
+        Entry* entry = m_ready.front();
+        m_ready.pop_front();
+        entry->state = Entry::RUNNING;
+        lock.unlock();
+        bool done = entry->task->resume(entry->wake);
+        lock.lock();
+
+        if (done)
+        {
+            entry->state = Entry::DONE;
+            if (--m_unfinished == 0)
+                m_changed.notify_all();
+        }
+        else if (entry->woken)
+        {
+            // Woken before it even stopped: go again
+            entry->woken = false;
+            entry->state = Entry::QUEUED;
+            m_ready.push_back(entry);
+        }
+        else
+            entry->state = Entry::PARKED;
+    }
+}
+
+void GameScheduler::wake(Entry* entry)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (entry->state == Entry::PARKED)
+    {
+        entry->state = Entry::QUEUED;
+        m_ready.push_back(entry);
+        m_changed.notify_one();
+    }
+    else if (entry->state == Entry::RUNNING)
+        entry->woken = true;
+}
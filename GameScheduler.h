@@ -0,0 +1,104 @@
+#ifndef GAMESCHEDULER_INCLUDED
+#define GAMESCHEDULER_INCLUDED
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Board;
+class Game;
+class GameEventSink;
+class Player;
+class ThreadPool;
+
+// Work that can stop part way through to wait for something, such as a
+// player's next shot, without holding a thread while it waits
+class ResumableTask
+{
+public:
+    virtual ~ResumableTask() {}
+
+    // Run until the task is finished, and return true, or until it has to
+    // wait, and return false.  In that case wake is called, from any
+    // thread, once resuming it would get further.
+    virtual bool resume(const std::function<void()>& wake) = 0;
+};
+
+// One game, played as Game::play plays it, but stopping whenever the
+// player to move has no shot ready instead of blocking until it has.
+// Players are asked with Player::tryAttack.  Ship placement still runs to
+// the end once started.
+class GameTask final : public ResumableTask
+{
+public:
+    explicit GameTask(const Game& g);
+    ~GameTask();
+
+    // Set up a game between p1, moving first, and p2 on boards the caller
+    // owns, which are reset.  Nothing is played until resume.  Returns
+    // false, leaving the task finished with no winner, if the game can't
+    // be played.
+    bool start(Player* p1, Player* p2, Board& b1, Board& b2, GameEventSink& sink);
+
+    bool resume(const std::function<void()>& wake) override;
+
+    bool finished() const;
+    // The winner of a finished game, or nullptr if ships couldn't be placed
+    Player* winner() const;
+
+    GameTask(const GameTask&) = delete;
+    GameTask& operator=(const GameTask&) = delete;
+
+private:
+    struct State;
+
+    const Game& m_game;
+    std::unique_ptr<State> m_state;     // null until started
+};
+
+// Runs any number of resumable tasks, such as thousands of games each
+// waiting on a slow human or a bot across the network, on the threads of a
+// ThreadPool.  A task that has to wait gives its thread back and is queued
+// again when it is woken, so a handful of threads keep every task that can
+// make progress busy.
+class GameScheduler
+{
+public:
+    explicit GameScheduler(ThreadPool& pool);
+
+    // The task must outlive run
+    void add(ResumableTask* task);
+
+    // Resume tasks on at most maxThreads threads, the caller's included
+    // (maxThreads <= 0 means no limit), until every task has finished
+    void run(int maxThreads = 0);
+
+    GameScheduler(const GameScheduler&) = delete;
+    GameScheduler& operator=(const GameScheduler&) = delete;
+
+private:
+    struct Entry
+    {
+        enum State { QUEUED, RUNNING, PARKED, DONE };
+
+        ResumableTask* task;
+        State state;
+        bool woken;                     // woken while running, so resume it again at once
+        std::function<void()> wake;
+    };
+
+    void workerLoop();
+    void wake(Entry* entry);
+
+    ThreadPool& m_pool;
+    std::vector<std::unique_ptr<Entry> > m_entries;
+    std::deque<Entry*> m_ready;         // tasks that can be resumed, oldest first
+    int m_unfinished;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+};
+
+#endif // GAMESCHEDULER_INCLUDED
@@ -0,0 +1,56 @@
+#ifndef GRID_INCLUDED
+#define GRID_INCLUDED
+
+#include <cstddef>
+#include <memory_resource>
+
+// Contiguous rows x cols array of a trivial type, stored row by row.
+// Grids of up to InlineCells cells live inside the object itself; larger
+// ones are allocated once from memory.
+template <class T, size_t InlineCells = 128>
+class Grid
+{
+public:
+    Grid(int nRows, int nCols, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : m_rows(nRows), m_cols(nCols), m_inline(), m_memory(memory),
+          m_heap(size() > static_cast<int>(InlineCells) ?
+              static_cast<T*>(memory->allocate(size() * sizeof(T), alignof(T))) : nullptr),
+          m_data(m_heap ? m_heap : m_inline)
+    {
+        fill(T());
+    }
+
+    ~Grid()
+    {
+        if (m_heap)
+            m_memory->deallocate(m_heap, size() * sizeof(T), alignof(T));
+    }
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int size() const { return m_rows * m_cols; }
+
+    T& operator()(int r, int c)             { return m_data[r * m_cols + c]; }
+    const T& operator()(int r, int c) const { return m_data[r * m_cols + c]; }
+    T& operator[](int i)                    { return m_data[i]; }
+    const T& operator[](int i) const        { return m_data[i]; }
+
+    void fill(const T& value)
+    {
+        for (int i = 0; i < size(); i++)
+            m_data[i] = value;
+    }
+
+    // m_data may point into this object, so a Grid is never copied
+    Grid(const Grid&) = delete;
+    Grid& operator=(const Grid&) = delete;
+
+private:
+    int m_rows, m_cols;
+    T m_inline[InlineCells > 0 ? InlineCells : 1];
+    std::pmr::memory_resource* m_memory;
+    T* m_heap;
+    T* m_data;
+};
+
+#endif // GRID_INCLUDED
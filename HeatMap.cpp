@@ -0,0 +1,117 @@
+#include "HeatMap.h"
+#include "Game.h"
+#include "PlacementTable.h"
+#include <algorithm>
+
+using namespace std;
+
+HeatMap::HeatMap(const Game& g)
+    : m_table(g.placementTable()), m_rows(g.rows()), m_cols(g.cols()),
+      m_count(g.memory()), m_shot(g.memory()), m_buckets(g.memory()), m_bucketPos(g.memory()), m_top(0)
+{
+    reset();
+}
+
+void HeatMap::reset()
+{
+    int nCells = m_rows * m_cols;
+    m_count.assign(nCells, 0);
+    m_shot.assign(nCells, 0);
+    m_bucketPos.assign(nCells, 0);
+
+    // With nothing shot yet, every in-bounds placement is legal
+    int maxCount = 0;
+    for (int i = 0; i < nCells; i++)
+    {
+        m_count[i] = m_table.coverage(i);
+        maxCount = max(maxCount, m_count[i]);
+    }
+
+    m_buckets.resize(maxCount + 1);
+    for (size_t k = 0; k < m_buckets.size(); k++)
+        m_buckets[k].clear();
+    for (int i = 0; i < nCells; i++)
+        addToBucket(i);
+    m_top = maxCount;
+}
+
+void HeatMap::removeFromBucket(int cell)
+{
+    pmr::vector<int>& bucket = m_buckets[m_count[cell]];
+    int last = bucket.back();
+    bucket[m_bucketPos[cell]] = last;
+    m_bucketPos[last] = m_bucketPos[cell];
+    bucket.pop_back();
+}
+
+void HeatMap::addToBucket(int cell)
+{
+    pmr::vector<int>& bucket = m_buckets[m_count[cell]];
+    m_bucketPos[cell] = static_cast<int>(bucket.size());
+    bucket.push_back(cell);
+}
+
+void HeatMap::adjust(int cell, int delta)
+{
+    // Shot cells are no longer candidates, so only their count changes
+    if (m_shot[cell])
+    {
+        m_count[cell] += delta;
+        return;
+    }
+    removeFromBucket(cell);
+    m_count[cell] += delta;
+    addToBucket(cell);
+}
+
+void HeatMap::updateLine(Point p, int len, int delta, bool vertical)
+{
+    int x = (vertical ? p.r : p.c);
+    int n = (vertical ? m_rows : m_cols);
+    int stride = (vertical ? m_cols : 1);
+    int origin = index(p) - x * stride;             // first cell of p's row or column
+
+    for (int start = max(0, x - len + 1); start <= min(x, n - len); start++)
+    {
+        // The segment only counted if nothing else on it had been shot
+        bool clear = true;
+        for (int k = start; k < start + len && clear; k++)
+            if (k != x && m_shot[origin + k * stride])
+                clear = false;
+        if (!clear)
+            continue;
+
+        for (int k = start; k < start + len; k++)
+            adjust(origin + k * stride, delta);
+    }
+}
+
+void HeatMap::markShot(Point p)
+{
+    int cell = index(p);
+    if (m_shot[cell])
+        return;
+
+    removeFromBucket(cell);
+    m_shot[cell] = 1;
+
+    // Every placement through p is now illegal
+    for (int k = 0; k < m_table.nLengths(); k++)
+    {
+        updateLine(p, m_table.length(k), -m_table.multiplicity(k), true);
+        updateLine(p, m_table.length(k), -m_table.multiplicity(k), false);
+    }
+
+    // Counts only go down, so the top bucket can only move down
+    while (m_top > 0 && m_buckets[m_top].empty())
+        --m_top;
+}
+
+bool HeatMap::best(Point& p) const
+{
+    if (m_top <= 0)
+        return false;
+    int cell = m_buckets[m_top].front();
+    p = Point(cell / m_cols, cell % m_cols);
+    return true;
+}
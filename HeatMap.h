@@ -0,0 +1,60 @@
+#ifndef HEATMAP_INCLUDED
+#define HEATMAP_INCLUDED
+
+#include "globals.h"
+#include <memory_resource>
+#include <vector>
+
+class Game;
+class PlacementTable;
+
+// Probability-density targeting data for one opponent board.  For every
+// cell it keeps the number of ship placements that cover the cell without
+// crossing a cell that has already been shot, counting each ship of the
+// fleet separately.  Shooting a cell only changes placements through that
+// cell's row and column, so each update costs O(sum of length^2) no matter
+// how big the board is.  Cells are also kept in buckets by count, so the
+// best target is found without scanning the board.
+class HeatMap
+{
+public:
+    HeatMap(const Game& g);
+
+    // Forget every shot and recompute the counts for an empty board
+    void reset();
+
+    // Record that p has been shot, so no unknown ship can cover it
+    void markShot(Point p);
+
+    bool isShot(Point p) const { return m_shot[index(p)]; }
+
+    // Number of legal placements covering p
+    int weight(Point p) const { return m_count[index(p)]; }
+
+    // Set p to an unshot cell with the highest weight.  Returns false if
+    // every unshot cell has weight 0.
+    bool best(Point& p) const;
+
+private:
+    int index(Point p) const { return p.r * m_cols + p.c; }
+
+    // Add delta to the count of a cell, moving it to its new bucket
+    void adjust(int cell, int delta);
+    void removeFromBucket(int cell);
+    void addToBucket(int cell);
+
+    // Apply delta to every cell of each segment of length len through p
+    // along one line that is clear of shots other than p itself
+    void updateLine(Point p, int len, int delta, bool vertical);
+
+    const PlacementTable& m_table;      // fleet grouped by ship length, and empty-board counts
+    int m_rows, m_cols;
+
+    std::pmr::vector<int> m_count;      // placements covering each cell
+    std::pmr::vector<char> m_shot;      // cells already shot
+    std::pmr::vector<std::pmr::vector<int> > m_buckets;     // unshot cells grouped by count
+    std::pmr::vector<int> m_bucketPos;  // position of each unshot cell in its bucket
+    int m_top;                          // highest non-empty bucket
+};
+
+#endif // HEATMAP_INCLUDED
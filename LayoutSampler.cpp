@@ -0,0 +1,180 @@
+#include "LayoutSampler.h"
+#include "Game.h"
+#include "PlacementTable.h"
+#include "Zobrist.h"
+#include <algorithm>
+
+using namespace std;
+
+LayoutSampler::LayoutSampler(const Game& g)
+    : m_table(g.placementTable()), m_state(g.rows(), g.cols(), g.memory()),
+      m_hits(g.memory()), m_sunkCell(g.nShips(), -1, g.memory()), m_hash(0)
+{
+    m_state.fill(UNKNOWN);
+}
+
+void LayoutSampler::reset()
+{
+    m_state.fill(UNKNOWN);
+    m_hits.clear();
+    fill(m_sunkCell.begin(), m_sunkCell.end(), -1);
+    m_hash = 0;
+}
+
+void LayoutSampler::recordMiss(int cell)
+{
+    m_state[cell] = MISS;
+    m_hash ^= Zobrist::miss(cell);
+}
+
+void LayoutSampler::recordHit(int cell)
+{
+    m_state[cell] = HIT;
+    m_hits.push_back(cell);
+    m_hash ^= Zobrist::hit(cell);
+}
+
+void LayoutSampler::recordSunk(int shipId, int cell)
+{
+    m_sunkCell[shipId] = cell;
+    m_hash ^= Zobrist::sunk(shipId);
+}
+
+bool LayoutSampler::sample(Rng& rng, Scratch& scratch, vector<int>& cells) const
+{
+    size_t nCells = m_table.rows() * m_table.cols();
+    if (scratch.occupied.size() != nCells)
+        scratch.occupied.assign(nCells, 0);
+    scratch.start.resize(m_table.nShips());
+    scratch.stride.resize(m_table.nShips());
+    scratch.placed.clear();
+
+    size_t nCellsBefore = cells.size();
+    bool ok = sampleLayout(rng, scratch, cells);
+    if (!ok)
+        cells.resize(nCellsBefore);
+
+    // Leave occupied all zero for the next call
+    for (size_t i = 0; i < scratch.placed.size(); i++)
+        scratch.occupied[scratch.placed[i]] = 0;
+    return ok;
+}
+
+bool LayoutSampler::legal(int shipId, int start, int stride, bool sunk, const vector<char>& occupied) const
+{
+    // A sunk ship lies entirely on hits.  A ship still afloat avoids misses
+    // and has at least one cell that hasn't been hit.
+    bool allHit = true;
+    for (int k = 0, i = start; k < m_table.shipLength(shipId); k++, i += stride)
+    {
+        if (occupied[i] || m_state[i] == MISS)
+            return false;
+        if (m_state[i] != HIT)
+            allHit = false;
+    }
+    return sunk == allHit;
+}
+
+bool LayoutSampler::placeThrough(Rng& rng, int shipId, int cell, bool sunk,
+    const vector<char>& occupied, int& start, int& stride) const
+{
+    int len = m_table.shipLength(shipId);
+    int r = cell / m_table.cols();
+    int c = cell % m_table.cols();
+
+    // Collect every legal placement covering cell
+    int segs[2 * MAXCOLS];
+    int n = 0;
+    for (int k = 0; k < len; k++)
+    {
+        int h = m_table.segmentAt(shipId, Point(r, c - k), HORIZONTAL);
+        int v = m_table.segmentAt(shipId, Point(r - k, c), VERTICAL);
+        if (h >= 0 && legal(shipId, cell - k, 1, sunk, occupied))
+            segs[n++] = h;
+        if (v >= 0 && legal(shipId, cell - k * m_table.cols(), m_table.cols(), sunk, occupied))
+            segs[n++] = v;
+    }
+    if (n == 0)
+        return false;
+
+    PlacementTable::Segment s = m_table.segment(shipId, segs[rng.nextInt(n)]);
+    start = s.start;
+    stride = s.stride;
+    return true;
+}
+
+bool LayoutSampler::sampleLayout(Rng& rng, Scratch& scratch, vector<int>& cells) const
+{
+    vector<int>& order = scratch.order;
+    vector<char>& occupied = scratch.occupied;
+    vector<int>& placed = scratch.placed;
+    int nShips = m_table.nShips();
+    order.resize(nShips);
+    for (int k = 0; k < nShips; k++)
+        order[k] = k;
+    rng.shuffle(order.begin(), order.end());
+
+    // Sunk ships must cover the hit that sank them
+    for (int k = 0; k < nShips; k++)
+    {
+        int shipId = order[k];
+        if (m_sunkCell[shipId] < 0)
+            continue;
+        int start, stride;
+        if (!placeThrough(rng, shipId, m_sunkCell[shipId], true, occupied, start, stride))
+            return false;
+        scratch.start[shipId] = start;
+        scratch.stride[shipId] = stride;
+        for (int j = 0, i = start; j < m_table.shipLength(shipId); j++, i += stride)
+        {
+            occupied[i] = 1;
+            placed.push_back(i);
+        }
+    }
+
+    // Ships still afloat try to explain a hit nobody covers yet, otherwise go anywhere legal
+    for (int k = 0; k < nShips; k++)
+    {
+        int shipId = order[k];
+        if (m_sunkCell[shipId] >= 0)
+            continue;
+        int len = m_table.shipLength(shipId);
+
+        int uncovered = -1;
+        int nUncovered = 0;
+        for (size_t h = 0; h < m_hits.size(); h++)
+            if (!occupied[m_hits[h]] && rng.nextInt(++nUncovered) == 0)
+                uncovered = m_hits[h];
+
+        int start = -1, stride = 1;
+        if (uncovered >= 0 && !placeThrough(rng, shipId, uncovered, false, occupied, start, stride))
+            start = -1;
+        for (int tries = 0; start < 0 && tries < 32 && m_table.nSegments(shipId) > 0; tries++)
+        {
+            PlacementTable::Segment s = m_table.segment(shipId, rng.nextInt(m_table.nSegments(shipId)));
+            if (legal(shipId, s.start, s.stride, false, occupied))
+            {
+                start = s.start;
+                stride = s.stride;
+            }
+        }
+        if (start < 0)
+            return false;
+
+        scratch.start[shipId] = start;
+        scratch.stride[shipId] = stride;
+        for (int j = 0, i = start; j < len; j++, i += stride)
+        {
+            occupied[i] = 1;
+            placed.push_back(i);
+            if (m_state[i] == UNKNOWN)
+                cells.push_back(i);
+        }
+    }
+
+    // Every hit must belong to some ship
+    for (size_t h = 0; h < m_hits.size(); h++)
+        if (!occupied[m_hits[h]])
+            return false;
+    return true;
+}
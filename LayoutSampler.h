@@ -0,0 +1,67 @@
+#ifndef LAYOUTSAMPLER_INCLUDED
+#define LAYOUTSAMPLER_INCLUDED
+
+#include "globals.h"
+#include "Grid.h"
+#include <memory_resource>
+#include <vector>
+
+class Game;
+class PlacementTable;
+
+// Draws random complete fleet layouts that agree with everything seen of
+// one opponent board: every miss, every hit, and the hit that sank each
+// ship.  Drawing only reads the observations, so any number of threads
+// may sample from one sampler at once, each with its own generator and
+// scratch space.
+class LayoutSampler
+{
+public:
+    enum CellState { UNKNOWN, MISS, HIT };
+
+    // Working space for sample, kept by the caller and reused across calls
+    struct Scratch
+    {
+        std::vector<char> occupied;
+        std::vector<int> order;
+        std::vector<int> placed;
+        std::vector<int> start;             // where each ship went in the last layout drawn
+        std::vector<int> stride;
+    };
+
+    LayoutSampler(const Game& g);
+
+    // Forget every observation
+    void reset();
+
+    void recordMiss(int cell);
+    void recordHit(int cell);
+    // cell must already have been recorded as a hit
+    void recordSunk(int shipId, int cell);
+
+    CellState state(int cell) const { return static_cast<CellState>(m_state[cell]); }
+    bool isSunk(int shipId) const { return m_sunkCell[shipId] >= 0; }
+    const PlacementTable& table() const { return m_table; }
+    // Zobrist hash of the observations, as Board::stateHash gives it
+    uint64_t stateHash() const { return m_hash; }
+
+    // Try to place the whole fleet consistently with the observations.  On
+    // success every unknown cell covered by a ship still afloat is appended
+    // to cells, and scratch.start and scratch.stride hold each ship's place.
+    bool sample(Rng& rng, Scratch& scratch, std::vector<int>& cells) const;
+
+private:
+    bool sampleLayout(Rng& rng, Scratch& scratch, std::vector<int>& cells) const;
+    // Pick a random legal placement of shipId through cell, or return false
+    bool placeThrough(Rng& rng, int shipId, int cell, bool sunk, const std::vector<char>& occupied,
+        int& start, int& stride) const;
+    bool legal(int shipId, int start, int stride, bool sunk, const std::vector<char>& occupied) const;
+
+    const PlacementTable& m_table;          // every placement of every ship
+    Grid<char> m_state;                     // UNKNOWN, MISS or HIT for each cell
+    std::pmr::vector<int> m_hits;           // cells that were hits
+    std::pmr::vector<int> m_sunkCell;       // cell whose hit sank each ship, or -1
+    uint64_t m_hash;                        // Zobrist hash of the observations
+};
+
+#endif // LAYOUTSAMPLER_INCLUDED
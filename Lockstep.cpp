@@ -0,0 +1,352 @@
+#include "Lockstep.h"
+#include "Board.h"
+#include "Game.h"
+#include "globals.h"
+#include <map>
+
+using namespace std;
+
+// The lane loops are left to the vectorizer.  On x86 the kernels are also
+// built for AVX2, and the version the processor supports is chosen when
+// the program starts; their helpers are inlined into each version.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define LANE_KERNEL __attribute__((target_clones("avx2", "default")))
+#define LANE_HELPER inline __attribute__((always_inline))
+#else
+#define LANE_KERNEL
+#define LANE_HELPER inline
+#endif
+
+namespace
+{
+    const int LANES = LockstepEngine::LANES;
+
+    // out = in moved n cells towards cell 0, in every lane
+    LANE_HELPER void shiftDown(const uint64_t (*__restrict in)[LANES], int n, uint64_t (*__restrict out)[LANES])
+    {
+        if (n == 0)
+            for (int l = 0; l < LANES; l++)
+            {
+                out[0][l] = in[0][l];
+                out[1][l] = in[1][l];
+            }
+        else if (n < 64)
+            for (int l = 0; l < LANES; l++)
+            {
+                out[0][l] = (in[0][l] >> n) | (in[1][l] << (64 - n));
+                out[1][l] = in[1][l] >> n;
+            }
+        else
+            for (int l = 0; l < LANES; l++)
+            {
+                out[0][l] = in[1][l] >> (n - 64);
+                out[1][l] = 0;
+            }
+    }
+
+    // out = in moved n cells away from cell 0, in every lane
+    LANE_HELPER void shiftUp(const uint64_t (*__restrict in)[LANES], int n, uint64_t (*__restrict out)[LANES])
+    {
+        if (n == 0)
+            for (int l = 0; l < LANES; l++)
+            {
+                out[0][l] = in[0][l];
+                out[1][l] = in[1][l];
+            }
+        else if (n < 64)
+            for (int l = 0; l < LANES; l++)
+            {
+                out[1][l] = (in[1][l] << n) | (in[0][l] >> (64 - n));
+                out[0][l] = in[0][l] << n;
+            }
+        else
+            for (int l = 0; l < LANES; l++)
+            {
+                out[1][l] = in[0][l] << (n - 64);
+                out[0][l] = 0;
+            }
+    }
+
+    // Add weight to the bit-sliced count of every cell in x, in every lane
+    LANE_HELPER void addCells(uint64_t (*__restrict count)[2][LANES], int planes, const uint64_t (*x)[LANES], int weight)
+    {
+        uint64_t carry[2][LANES];
+        for (int b = 0; b < planes; b++)
+        {
+            if ((weight & (1 << b)) == 0)
+                continue;
+            for (int l = 0; l < LANES; l++)
+            {
+                carry[0][l] = x[0][l];
+                carry[1][l] = x[1][l];
+            }
+            for (int p = b; p < planes; p++)
+                for (int w = 0; w < 2; w++)
+                    for (int l = 0; l < LANES; l++)
+                    {
+                        uint64_t c = count[p][w][l] & carry[w][l];
+                        count[p][w][l] ^= carry[w][l];
+                        carry[w][l] = c;
+                    }
+        }
+    }
+
+    // Narrow cand to its cells with the largest count, in every lane.
+    // From the top plane down, a plane's cells are kept whenever any
+    // candidate has that bit set.
+    LANE_HELPER void keepLargest(uint64_t (*__restrict cand)[LANES], const uint64_t (*__restrict count)[2][LANES], int planes)
+    {
+        for (int p = planes - 1; p >= 0; p--)
+            for (int l = 0; l < LANES; l++)
+            {
+                uint64_t t0 = cand[0][l] & count[p][0][l];
+                uint64_t t1 = cand[1][l] & count[p][1][l];
+                uint64_t keep = -static_cast<uint64_t>((t0 | t1) != 0);
+                cand[0][l] = (t0 & keep) | (cand[0][l] & ~keep);
+                cand[1][l] = (t1 & keep) | (cand[1][l] & ~keep);
+            }
+    }
+}
+
+bool LockstepEngine::targetingOf(const string& type, Targeting& t)
+{
+    // createPlayer gives "a/b/c" the targeting of c
+    string name = type.substr(type.rfind('/') + 1);
+    name = name.substr(0, name.find(':'));
+    if (name == "awful")
+        t = SWEEP;
+    else if (name == "heat")
+        t = HEAT;
+    else
+        return false;
+    return true;
+}
+
+bool LockstepEngine::supports(const Game& g)
+{
+    return g.rows() * g.cols() <= WORDS * 64;
+}
+
+LockstepEngine::LockstepEngine(const Game& g, Targeting first, Targeting second)
+    : m_rows(g.rows()), m_cols(g.cols()), m_nCells(g.rows() * g.cols()), m_targeting{ first, second }
+{
+    for (int w = 0; w < WORDS; w++)
+    {
+        int n = m_nCells - 64 * w;
+        m_board[w] = (n >= 64 ? ~uint64_t(0) : n > 0 ? (uint64_t(1) << n) - 1 : 0);
+    }
+
+    // Ships of the same length share their placements
+    map<int, int> counts;
+    for (int k = 0; k < g.nShips(); k++)
+    {
+        m_lengths.push_back(g.shipLength(k));
+        counts[g.shipLength(k)]++;
+    }
+    int maxCount = 0;
+    for (auto it = counts.begin(); it != counts.end(); ++it)
+    {
+        LengthGroup group;
+        group.length = it->first;
+        group.count = it->second;
+        for (int dir = 0; dir < 2; dir++)
+            for (int w = 0; w < WORDS; w++)
+                group.fits[dir][w] = 0;
+        for (int r = 0; r < m_rows; r++)
+            for (int c = 0; c < m_cols; c++)
+            {
+                int cell = r * m_cols + c;
+                if (cell >= WORDS * 64)
+                    continue;
+                if (c + group.length <= m_cols)
+                    group.fits[0][cell >> 6] |= uint64_t(1) << (cell & 63);
+                if (r + group.length <= m_rows)
+                    group.fits[1][cell >> 6] |= uint64_t(1) << (cell & 63);
+            }
+        m_groups.push_back(group);
+        // A cell is covered by at most length placements each way per ship
+        maxCount += 2 * group.length * group.count;
+    }
+    m_planes = 1;
+    while (m_planes < MAX_PLANES && (1 << m_planes) <= maxCount)
+        m_planes++;
+
+    for (int l = 0; l < LANES; l++)
+    {
+        m_winner[l] = -1;
+        m_turns[l] = 0;
+    }
+}
+
+bool LockstepEngine::load(int lane, const Board& firstBoard, const Board& secondBoard)
+{
+    const Board* boards[2] = { &firstBoard, &secondBoard };
+    for (int j = 0; j < 2; j++)
+    {
+        Side& side = m_sides[j];
+        for (int w = 0; w < WORDS; w++)
+        {
+            side.ships[w][lane] = 0;
+            side.hits[w][lane] = 0;
+            side.misses[w][lane] = 0;
+        }
+        for (int k = 0; k < static_cast<int>(m_lengths.size()); k++)
+        {
+            Point topOrLeft;
+            Direction dir;
+            if (!boards[j]->shipPlacement(k, topOrLeft, dir))
+                return false;
+            int start = topOrLeft.r * m_cols + topOrLeft.c;
+            int step = (dir == HORIZONTAL ? 1 : m_cols);
+            for (int i = 0; i < m_lengths[k]; i++)
+            {
+                int cell = start + i * step;
+                side.ships[cell >> 6][lane] |= uint64_t(1) << (cell & 63);
+            }
+        }
+    }
+    return true;
+}
+
+int LockstepEngine::shots(int lane, int player) const
+{
+    // The player moving first takes the odd-numbered turns, counting from 1
+    return player == 0 ? (m_turns[lane] + 1) / 2 : m_turns[lane] / 2;
+}
+
+void LockstepEngine::sweepShots(int shotsTaken)
+{
+    // Every lane is at the same point of the same sweep
+    int cell = m_nCells - 1 - shotsTaken % m_nCells;
+    for (int w = 0; w < WORDS; w++)
+    {
+        uint64_t bit = (cell >> 6 == w ? uint64_t(1) << (cell & 63) : 0);
+        for (int l = 0; l < LANES; l++)
+            m_shot[w][l] = bit;
+    }
+}
+
+LANE_KERNEL
+void LockstepEngine::heatShots(int defender)
+{
+    const Side& target = m_sides[defender];
+    for (int w = 0; w < WORDS; w++)
+        for (int l = 0; l < LANES; l++)
+            m_free[w][l] = ~target.misses[w][l] & m_board[w];
+    for (int p = 0; p < m_planes; p++)
+        for (int w = 0; w < WORDS; w++)
+            for (int l = 0; l < LANES; l++)
+            {
+                m_count[p][w][l] = 0;
+                m_hitCount[p][w][l] = 0;
+            }
+
+    // Count the placements of every ship across and down that cross no miss,
+    // and separately those that also cross a hit
+    for (size_t g = 0; g < m_groups.size(); g++)
+    {
+        const LengthGroup& group = m_groups[g];
+        for (int dir = 0; dir < 2; dir++)
+        {
+            int step = (dir == 0 ? 1 : m_cols);
+            for (int w = 0; w < WORDS; w++)
+                for (int l = 0; l < LANES; l++)
+                {
+                    m_starts[w][l] = m_free[w][l] & group.fits[dir][w];
+                    m_hitStarts[w][l] = 0;
+                }
+            for (int i = 0; i < group.length; i++)
+            {
+                shiftDown(m_free, i * step, m_shifted);
+                for (int w = 0; w < WORDS; w++)
+                    for (int l = 0; l < LANES; l++)
+                        m_starts[w][l] &= m_shifted[w][l];
+                shiftDown(target.hits, i * step, m_shifted);
+                for (int w = 0; w < WORDS; w++)
+                    for (int l = 0; l < LANES; l++)
+                        m_hitStarts[w][l] |= m_shifted[w][l];
+            }
+            for (int w = 0; w < WORDS; w++)
+                for (int l = 0; l < LANES; l++)
+                    m_hitStarts[w][l] &= m_starts[w][l];
+
+            for (int i = 0; i < group.length; i++)
+            {
+                shiftUp(m_starts, i * step, m_shifted);
+                addCells(m_count, m_planes, m_shifted, group.count);
+                shiftUp(m_hitStarts, i * step, m_shifted);
+                addCells(m_hitCount, m_planes, m_shifted, group.count);
+            }
+        }
+    }
+
+    // Among the unknown cells, the most placements through a hit, then the
+    // most placements, then the lowest cell
+    for (int w = 0; w < WORDS; w++)
+        for (int l = 0; l < LANES; l++)
+            m_shot[w][l] = ~(target.hits[w][l] | target.misses[w][l]) & m_board[w];
+    keepLargest(m_shot, m_hitCount, m_planes);
+    keepLargest(m_shot, m_count, m_planes);
+    for (int l = 0; l < LANES; l++)
+    {
+        uint64_t lowest = m_shot[0][l] & -m_shot[0][l];
+        m_shot[1][l] = (lowest != 0 ? 0 : m_shot[1][l] & -m_shot[1][l]);
+        m_shot[0][l] = lowest;
+    }
+}
+
+LANE_KERNEL
+uint64_t LockstepEngine::resolve(int defender)
+{
+    Side& target = m_sides[defender];
+    for (int w = 0; w < WORDS; w++)
+        for (int l = 0; l < LANES; l++)
+        {
+            uint64_t shot = m_shot[w][l] & m_live[l];
+            target.hits[w][l] |= shot & target.ships[w][l];
+            target.misses[w][l] |= shot & ~target.ships[w][l];
+        }
+    for (int l = 0; l < LANES; l++)
+        m_left[l] = (target.ships[0][l] & ~target.hits[0][l]) | (target.ships[1][l] & ~target.hits[1][l]);
+
+    uint64_t over = 0;
+    for (int l = 0; l < LANES; l++)
+        over |= uint64_t(m_left[l] == 0 && m_live[l] != 0) << l;
+    return over;
+}
+
+void LockstepEngine::run(int nLanes)
+{
+    int nLive = 0;
+    for (int l = 0; l < LANES; l++)
+    {
+        m_live[l] = (l < nLanes ? ~uint64_t(0) : 0);
+        m_winner[l] = -1;
+        m_turns[l] = 0;
+    }
+
+    // A sweep covers the board in m_nCells shots and HeatPlayer never fires
+    // at a cell twice, so every game is over by then
+    int maxTurns = 2 * m_nCells;
+    int turn;
+    for (turn = 0, nLive = nLanes; nLive > 0 && turn < maxTurns; turn++)
+    {
+        int mover = turn % 2;
+        if (m_targeting[mover] == SWEEP)
+            sweepShots(turn / 2);
+        else
+            heatShots(1 - mover);
+
+        for (uint64_t over = resolve(1 - mover); over != 0; over &= over - 1)
+        {
+            int l = __builtin_ctzll(over);
+            m_live[l] = 0;
+            m_winner[l] = mover;
+            m_turns[l] = turn + 1;
+            nLive--;
+        }
+    }
+    for (int l = 0; l < nLanes; l++)
+        if (m_live[l] != 0)
+            m_turns[l] = turn;
+}
@@ -0,0 +1,118 @@
+#ifndef LOCKSTEP_INCLUDED
+#define LOCKSTEP_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Board;
+class Game;
+
+// Plays up to LANES games at once, turn by turn in lockstep, for players
+// whose shots follow from what they have seen by a fixed rule: AwfulPlayer
+// and HeatPlayer.  Placement is left to the players themselves; load()
+// copies the fleets from their boards.
+//
+// State is kept in structure-of-arrays form, one lane per game.  Each board
+// is a pair of 64-bit words per lane for its ships, hits and misses, so
+// boards of up to SMALL_BOARD_CELLS cells fit.  Every step of a turn, from
+// choosing the shot through resolving it to checking whether the fleet is
+// gone, is a loop over the lanes with no branches that depend on the lane,
+// which the compiler turns into vector instructions.  Games that are over
+// keep running with their state frozen until the last lane finishes.
+//
+// HeatPlayer's placement counts are kept bit-sliced: plane p of a counter
+// holds bit p of every cell's count, so adding a set of cells to the counts
+// and finding the cells with the largest count are a handful of word
+// operations each.
+//
+// The players' own code is the reference.  tournament -l 2 plays every
+// game both ways and reports any that differ.
+class LockstepEngine
+{
+public:
+    static constexpr int LANES = 64;
+
+    enum Targeting
+    {
+        SWEEP,      // AwfulPlayer: every cell in turn, from the last
+        HEAT        // HeatPlayer: the unknown cell covered by the most placements
+    };
+
+    // Set t to how player type chooses its shots, following any
+    // "placement/" prefix; false if the engine can't run that player
+    static bool targetingOf(const std::string& type, Targeting& t);
+
+    // True if g's board is small enough
+    static bool supports(const Game& g);
+
+    // Games between a player targeting like first, who moves first, and one
+    // targeting like second
+    LockstepEngine(const Game& g, Targeting first, Targeting second);
+
+    // Start lane's game with the fleets on the boards of the player moving
+    // first and the other; false if either is missing a ship
+    bool load(int lane, const Board& firstBoard, const Board& secondBoard);
+
+    // Play the games in lanes 0 to nLanes-1 to the end
+    void run(int nLanes);
+
+    // 0 if the player moving first won lane's game, 1 if the other did, -1
+    // if neither could finish
+    int winner(int lane) const { return m_winner[lane]; }
+
+    // Shots taken in lane's game by the player moving first (0) or second (1)
+    int shots(int lane, int player) const;
+
+    LockstepEngine(const LockstepEngine&) = delete;
+    LockstepEngine& operator=(const LockstepEngine&) = delete;
+
+private:
+    static constexpr int WORDS = 2;         // of a board
+    static constexpr int MAX_PLANES = 16;   // of a placement counter
+
+    typedef uint64_t Lanes[WORDS][LANES];   // a set of cells in every lane
+
+    // One board in every lane, as the player attacking it has seen it
+    struct Side
+    {
+        Lanes ships;
+        Lanes hits;
+        Lanes misses;
+    };
+
+    // Ships of one length and the cells where one of them can start
+    struct LengthGroup
+    {
+        int length;
+        int count;                          // ships of this length
+        uint64_t fits[2][WORDS];            // across, down
+    };
+
+    // Set m_shot to the cell each lane's attacker fires at next
+    void sweepShots(int shotsTaken);
+    void heatShots(int defender);
+    // Fire m_shot at defender's board in every live lane; return the lanes
+    // whose fleet is now gone
+    uint64_t resolve(int defender);
+
+    int m_rows, m_cols, m_nCells;
+    Targeting m_targeting[2];               // by move order
+    uint64_t m_board[WORDS];                // every cell of the board
+    std::vector<int> m_lengths;             // of each ship
+    std::vector<LengthGroup> m_groups;
+    int m_planes;                           // enough for any cell's count
+
+    Side m_sides[2];                        // board of the player moving first, and the other
+    Lanes m_shot;                           // the cell each lane fires at this turn
+    uint64_t m_live[LANES];                 // all ones while the lane's game goes on
+    uint64_t m_left[LANES];                 // ship cells not yet hit
+    int m_winner[LANES];
+    int m_turns[LANES];                     // turns played, including the winning shot
+
+    // Working storage for heatShots
+    Lanes m_free, m_starts, m_hitStarts, m_shifted;
+    Lanes m_count[MAX_PLANES], m_hitCount[MAX_PLANES];
+};
+
+#endif // LOCKSTEP_INCLUDED
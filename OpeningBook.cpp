@@ -0,0 +1,135 @@
+#include "OpeningBook.h"
+#include "Game.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[4] = { 'B', 'S', 'O', 'B' };
+    const uint16_t VERSION = 1;
+
+    using BinaryFile::padded;
+    using BinaryFile::put;
+    using BinaryFile::get;
+}
+
+OpeningBook::OpeningBook(const string& path)
+    : m_file(path, MappedFile::RANDOM),     // lookups jump around the state table
+      m_states(nullptr), m_cells(nullptr), m_size(0), m_rows(0), m_cols(0), m_plies(0)
+{
+    if (m_file.isOpen() && !readHeader())
+    {
+        m_file.close();
+        m_states = nullptr;
+        m_cells = nullptr;
+        m_size = 0;
+    }
+}
+
+bool OpeningBook::readHeader()
+{
+    const char* p = m_file.begin();
+    const char* end = m_file.end();
+    char magic[sizeof(MAGIC)];
+    uint16_t version, rows, cols, nShips, plies;
+    uint32_t headerBytes, entries;
+    if (!get(p, end, magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        !get(p, end, version) || version != VERSION ||
+        !get(p, end, headerBytes) || headerBytes % 8 != 0 ||
+        !get(p, end, rows) || !get(p, end, cols) || !get(p, end, nShips) ||
+        !get(p, end, plies) || !get(p, end, entries))
+        return false;
+
+    m_fleet.resize(nShips);
+    for (int k = 0; k < nShips; k++)
+    {
+        uint16_t len;
+        if (!get(p, end, len))
+            return false;
+        m_fleet[k] = len;
+    }
+    uint8_t len;
+    if (!get(p, end, len) || end - p < len)
+        return false;
+    m_type.assign(p, len);
+    p += len;
+
+    // The tables must fit in the file after the header
+    size_t tableBytes = static_cast<size_t>(entries) * (sizeof(uint64_t) + sizeof(uint32_t));
+    if (p > m_file.begin() + headerBytes || headerBytes + tableBytes > m_file.size())
+        return false;
+
+    // Players index their boards with a book's cells unchecked, so a cell
+    // off the board spoils the whole book
+    const uint64_t* states = reinterpret_cast<const uint64_t*>(m_file.begin() + headerBytes);
+    const uint32_t* cells = reinterpret_cast<const uint32_t*>(states + entries);
+    uint32_t nCells = static_cast<uint32_t>(rows) * cols;
+    for (uint32_t k = 0; k < entries; k++)
+        if (cells[k] >= nCells)
+            return false;
+
+    m_rows = rows;
+    m_cols = cols;
+    m_plies = plies;
+    m_size = entries;
+    m_states = states;
+    m_cells = cells;
+    return true;
+}
+
+bool OpeningBook::matches(const Game& g) const
+{
+    if (!isOpen() || g.rows() != m_rows || g.cols() != m_cols || g.nShips() != static_cast<int>(m_fleet.size()))
+        return false;
+    for (int k = 0; k < g.nShips(); k++)
+        if (g.shipLength(k) != m_fleet[k])
+            return false;
+    return true;
+}
+
+int OpeningBook::lookup(uint64_t state) const
+{
+    const uint64_t* end = m_states + m_size;
+    const uint64_t* found = lower_bound(m_states, end, state);
+    if (found == end || *found != state)
+        return -1;
+    return static_cast<int>(m_cells[found - m_states]);
+}
+
+bool OpeningBook::write(const string& path, const Game& g, const string& type, int plies,
+    vector<OpeningBookEntry> entries)
+{
+    sort(entries.begin(), entries.end(), [](const OpeningBookEntry& a, const OpeningBookEntry& b) {
+        return a.state < b.state;
+    });
+
+    vector<char> out(MAGIC, MAGIC + sizeof(MAGIC));
+    put<uint16_t>(out, VERSION);
+    put<uint32_t>(out, 0);                              // filled in below
+    put<uint16_t>(out, static_cast<uint16_t>(g.rows()));
+    put<uint16_t>(out, static_cast<uint16_t>(g.cols()));
+    put<uint16_t>(out, static_cast<uint16_t>(g.nShips()));
+    put<uint16_t>(out, static_cast<uint16_t>(plies));
+    put<uint32_t>(out, static_cast<uint32_t>(entries.size()));
+    for (int k = 0; k < g.nShips(); k++)
+        put<uint16_t>(out, static_cast<uint16_t>(g.shipLength(k)));
+    string name = type.substr(0, 255);
+    put<uint8_t>(out, static_cast<uint8_t>(name.size()));
+    out.insert(out.end(), name.begin(), name.end());
+    out.resize(padded(out.size()), 0);
+    uint32_t headerBytes = static_cast<uint32_t>(out.size());
+    memcpy(&out[sizeof(MAGIC) + sizeof(VERSION)], &headerBytes, sizeof(headerBytes));
+
+    for (size_t k = 0; k < entries.size(); k++)
+        put<uint64_t>(out, entries[k].state);
+    for (size_t k = 0; k < entries.size(); k++)
+        put<uint32_t>(out, entries[k].cell);
+    out.resize(padded(out.size()), 0);
+
+    ofstream file(path, ios::binary | ios::trunc);
+    file.write(out.data(), out.size());
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,77 @@
+#ifndef OPENINGBOOK_INCLUDED
+#define OPENINGBOOK_INCLUDED
+
+#include "BinaryFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Game;
+
+// Shots worked out ahead of time for the first few plies of a game.  Early
+// on, what an attacker has seen of a board is the same in many games, and
+// so is the shot a probability-driven player takes next; a book built once
+// by the book tool lets players look that shot up instead of working it
+// out again in every game.
+//
+// A book is keyed by the Zobrist hash of the observed state (see Zobrist.h
+// and Board::stateHash), and is only valid for the board size and fleet it
+// was built for.  The file is mapped into memory and searched in place, so
+// one loaded book can be shared by every game and thread of a run.
+//
+// File layout, in the byte order of the machine that wrote it:
+//
+//   "BSOB", version, header bytes, rows, cols, ships, plies, entries,
+//   ship lengths, the player type that built it, padding to 8 bytes
+//   uint64_t state[entries]             ascending
+//   uint32_t cell[entries]              r * cols + c of the shot for each state
+
+struct OpeningBookEntry
+{
+    uint64_t state;                     // Zobrist hash of what the attacker has seen
+    uint32_t cell;                      // the shot to take there
+};
+
+class OpeningBook
+{
+public:
+    // Maps path into memory.  Check isOpen() before use: a file that is
+    // cut short or has a cell off its board doesn't open.
+    explicit OpeningBook(const std::string& path);
+
+    bool isOpen() const { return m_states != nullptr; }
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    const std::vector<int>& fleet() const { return m_fleet; }
+    const std::string& type() const { return m_type; }      // player type that built the book
+    int plies() const { return m_plies; }
+    size_t size() const { return m_size; }
+
+    // True if the book was built for games of g's size and fleet
+    bool matches(const Game& g) const;
+
+    // The cell to shoot in the observed state, or -1 if the book has none
+    int lookup(uint64_t state) const;
+
+    // Write a book for games like g.  Entries may be in any order; a state
+    // must appear only once.
+    static bool write(const std::string& path, const Game& g, const std::string& type, int plies,
+        std::vector<OpeningBookEntry> entries);
+
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+private:
+    bool readHeader();
+
+    MappedFile m_file;
+    const uint64_t* m_states;
+    const uint32_t* m_cells;
+    size_t m_size;
+    int m_rows, m_cols;
+    int m_plies;
+    std::vector<int> m_fleet;
+    std::string m_type;
+};
+
+#endif // OPENINGBOOK_INCLUDED
@@ -0,0 +1,286 @@
+#include "PlacementSolver.h"
+#include "Board.h"
+#include "Game.h"
+#include "BitMask.h"
+#include "Fleet.h"
+#include "PlacementTable.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <type_traits>
+
+using namespace std;
+
+namespace
+{
+    const int MAX_RESTARTS = 500;           // whole layouts drawn before searching instead
+    const int MAX_DRAWS = 4096;             // draws to find one ship a spot allowed by its own constraints
+    const long MAX_NODES = 1L << 22;        // placements the exhaustive search may try
+
+    // Where every Scratch on this thread spills, reused from solve to solve
+    pmr::memory_resource* spillPool()
+    {
+        static thread_local pmr::unsynchronized_pool_resource pool;
+        return &pool;
+    }
+}
+
+PlacementSolver::Scratch::Scratch()
+    : monotonic_buffer_resource(m_buffer, sizeof(m_buffer), spillPool())
+{}
+
+PlacementSolver::PlacementSolver(const Game& g, pmr::memory_resource* memory)
+    : m_game(g), m_memory(memory != nullptr ? memory : g.memory()),
+      m_forbidden(g.rows() * g.cols(), 0, m_memory), m_regions(g.nShips(), m_memory),
+      m_noTouching(false)
+{}
+
+void PlacementSolver::forbid(Point p)
+{
+    m_forbidden[p.r * m_game.cols() + p.c] = 1;
+}
+
+void PlacementSolver::clearForbidden()
+{
+    fill(m_forbidden.begin(), m_forbidden.end(), 0);
+}
+
+void PlacementSolver::restrictShip(int shipId, const pmr::vector<bool>& allowed)
+{
+    m_regions[shipId] = allowed;
+}
+
+PlacementSolver::Outcome PlacementSolver::solve(Rng& rng, Layout& layout) const
+{
+    // The backtracking search has a long tail on crowded boards
+    PROFILE_SCOPE("placementSolver.solve");
+    const PlacementTable& table = m_game.placementTable();
+    if (!table.hasMasks())
+        return solveWith<0, void>(rng, layout);
+    if (StandardFleet::matches(table))
+        return solveWith<SMALL_BOARD_CELLS, StandardFleet>(rng, layout);
+    return solveWith<SMALL_BOARD_CELLS, void>(rng, layout);
+}
+
+template <size_t MaxCells, class Fleet>
+PlacementSolver::Outcome PlacementSolver::solveWith(Rng& rng, Layout& layout) const
+{
+    typedef BitMask<(MaxCells + 63) / 64> CellMask;
+    typedef PlacementTable::Segment Segment;
+    constexpr bool FIXED = !is_void<Fleet>::value;
+
+    const PlacementTable& table = m_game.placementTable();
+    int rows = table.rows();
+    int cols = table.cols();
+    int nCells = rows * cols;
+    int nShips = table.nShips();
+    pmr::memory_resource* memory = m_memory;
+
+    // A fixed fleet's lengths, placement counts and masks are constants
+    auto shipLength = [&](int shipId) {
+        if constexpr (FIXED)
+            return Fleet::LENGTHS[shipId];
+        return table.shipLength(shipId);
+    };
+    auto nSegments = [&](int shipId) {
+        if constexpr (FIXED)
+            return Fleet::nSegments(Fleet::LENGTHS[shipId]);
+        return table.nSegments(shipId);
+    };
+    auto mask = [&](int shipId, int seg) -> const PlacementTable::SmallMask& {
+        if constexpr (FIXED)
+            return Fleet::masks().mask(shipId, seg);
+        return table.mask(shipId, seg);
+    };
+    auto halo = [&](int shipId, int seg) -> const PlacementTable::SmallMask& {
+        if constexpr (FIXED)
+            return Fleet::masks().halo(shipId, seg);
+        return table.halo(shipId, seg);
+    };
+
+    // With masks, the cells each ship may not cover are gathered once
+    pmr::vector<CellMask> excluded(memory);
+    if constexpr (MaxCells != 0)
+    {
+        excluded.assign(nShips, CellMask(nCells));
+        for (int shipId = 0; shipId < nShips; shipId++)
+        {
+            const pmr::vector<bool>& region = m_regions[shipId];
+            for (int i = 0; i < nCells; i++)
+                if (m_forbidden[i] || (!region.empty() && !region[i]))
+                    excluded[shipId].set(i);
+        }
+    }
+
+    // True if the placement avoids forbidden cells and stays inside the ship's region
+    auto allowed = [&](int shipId, int seg) {
+        if constexpr (MaxCells != 0)
+            return !mask(shipId, seg).intersects(excluded[shipId]);
+        const pmr::vector<bool>& region = m_regions[shipId];
+        Segment s = table.segment(shipId, seg);
+        for (int k = 0, i = s.start; k < shipLength(shipId); k++, i += s.stride)
+            if (m_forbidden[i] || (!region.empty() && !region[i]))
+                return false;
+        return true;
+    };
+
+    // True if no cell of the placement is taken by, or (with no touching) next to, another ship
+    auto fits = [&](const CellMask& taken, int shipId, int seg) {
+        if constexpr (MaxCells != 0)
+            return !mask(shipId, seg).intersects(taken);
+        Segment s = table.segment(shipId, seg);
+        for (int k = 0, i = s.start; k < shipLength(shipId); k++, i += s.stride)
+            if (taken.test(i))
+                return false;
+        return true;
+    };
+
+    auto take = [&](CellMask& taken, int shipId, int seg) {
+        if constexpr (MaxCells != 0)
+        {
+            taken |= (m_noTouching ? halo(shipId, seg) : mask(shipId, seg));
+            return;
+        }
+        Segment s = table.segment(shipId, seg);
+        for (int k = 0, i = s.start; k < shipLength(shipId); k++, i += s.stride)
+        {
+            taken.set(i);
+            if (m_noTouching)
+            {
+                int r = i / cols;
+                int c = i % cols;
+                if (r > 0)          taken.set(i - cols);
+                if (r < rows - 1)   taken.set(i + cols);
+                if (c > 0)          taken.set(i - 1);
+                if (c < cols - 1)   taken.set(i + 1);
+            }
+        }
+    };
+
+    auto output = [&](const pmr::vector<int>& chosen) {
+        layout.clear();
+        for (int shipId = 0; shipId < nShips; shipId++)
+        {
+            Segment s = table.segment(shipId, chosen[shipId]);
+            Placement p;
+            p.shipId = shipId;
+            p.topOrLeft = Point(s.start / cols, s.start % cols);
+            p.dir = s.dir;
+            layout.push_back(p);
+        }
+    };
+
+    // A ship longer than both sides of the board never fits
+    int fleetArea = 0;
+    for (int shipId = 0; shipId < nShips; shipId++)
+    {
+        if (nSegments(shipId) == 0)
+            return INFEASIBLE;
+        fleetArea += shipLength(shipId);
+    }
+    if (fleetArea > nCells - static_cast<int>(count(m_forbidden.begin(), m_forbidden.end(), 1)))
+        return INFEASIBLE;
+
+    // Phase 1: draw each ship uniformly from its allowed placements, and start
+    // the whole layout over on any conflict between ships
+    pmr::vector<int> chosen(nShips, memory);
+    bool sampling = true;
+    for (int restart = 0; sampling && restart < MAX_RESTARTS; restart++)
+    {
+        CellMask taken(nCells, memory);
+        bool ok = true;
+        for (int shipId = 0; ok && shipId < nShips; shipId++)
+        {
+            int seg = -1;
+            for (int draw = 0; seg < 0 && draw < MAX_DRAWS; draw++)
+            {
+                int x = rng.nextInt(nSegments(shipId));
+                if (allowed(shipId, x))
+                    seg = x;
+            }
+
+            // The ship's allowed placements are too rare to sample; leave it to the search
+            if (seg < 0)
+            {
+                sampling = false;
+                ok = false;
+            }
+            else if (!fits(taken, shipId, seg))
+                ok = false;
+            else
+            {
+                take(taken, shipId, seg);
+                chosen[shipId] = seg;
+            }
+        }
+        if (sampling && ok)
+        {
+            output(chosen);
+            return PLACED;
+        }
+    }
+
+    // Phase 2: exhaustive depth-first search over every ship's allowed
+    // placements in random order.  Longer ships go first since they have the
+    // fewest options.
+    pmr::vector<int> order(nShips, memory);
+    for (int k = 0; k < nShips; k++)
+        order[k] = k;
+    stable_sort(order.begin(), order.end(), [&shipLength](int a, int b) {
+        return shipLength(a) > shipLength(b);
+    });
+
+    pmr::vector<pmr::vector<int> > candidates(nShips, memory);
+    for (int shipId = 0; shipId < nShips; shipId++)
+    {
+        for (int seg = 0; seg < nSegments(shipId); seg++)
+            if (allowed(shipId, seg))
+                candidates[shipId].push_back(seg);
+        if (candidates[shipId].empty())
+            return INFEASIBLE;
+        rng.shuffle(candidates[shipId].begin(), candidates[shipId].end());
+    }
+
+    pmr::vector<CellMask> taken(nShips + 1, CellMask(nCells), memory);    // cells unavailable at each depth
+    pmr::vector<size_t> cursor(nShips + 1, 0, memory);                    // next candidate to try at each depth
+    long nodes = 0;
+    int depth = 0;
+    while (depth >= 0)
+    {
+        if (depth == nShips)
+        {
+            output(chosen);
+            return PLACED;
+        }
+
+        int shipId = order[depth];
+        const pmr::vector<int>& options = candidates[shipId];
+        bool found = false;
+        while (!found && cursor[depth] < options.size())
+        {
+            int seg = options[cursor[depth]++];
+            if (++nodes > MAX_NODES)
+                return UNDECIDED;
+            if (fits(taken[depth], shipId, seg))
+            {
+                taken[depth + 1] = taken[depth];
+                take(taken[depth + 1], shipId, seg);
+                chosen[shipId] = seg;
+                found = true;
+            }
+        }
+
+        if (found)
+            cursor[++depth] = 0;
+        else
+            --depth;                        // every option failed: revisit the previous ship
+    }
+    return INFEASIBLE;
+}
+
+bool PlacementSolver::apply(const Layout& layout, Board& b)
+{
+    for (size_t k = 0; k < layout.size(); k++)
+        if (!b.placeShip(layout[k].topOrLeft, layout[k].shipId, layout[k].dir))
+            return false;
+    return true;
+}
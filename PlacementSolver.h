@@ -0,0 +1,86 @@
+#ifndef PLACEMENTSOLVER_INCLUDED
+#define PLACEMENTSOLVER_INCLUDED
+
+#include "globals.h"
+#include <memory_resource>
+#include <vector>
+
+class Board;
+class Game;
+
+// Where one ship goes
+struct Placement
+{
+    int shipId;
+    Point topOrLeft;
+    Direction dir;
+};
+
+typedef std::pmr::vector<Placement> Layout;
+
+// Finds a layout of the whole fleet that satisfies a set of constraints:
+// cells no ship may use, cells a particular ship must stay inside, and
+// optionally that no two ships share an edge.
+//
+// solve() first draws every ship uniformly from its allowed placements and
+// starts over whenever two ships conflict, which samples uniformly among
+// all valid layouts.  If that keeps failing it switches to an exhaustive
+// randomized search, so an impossible fleet is reported as such instead of
+// being retried forever.
+//
+// Its working storage comes from the memory it is given, or the game's
+// memory resource.  Callers that solve once and throw the solver away can
+// use a Scratch to keep all of it on the stack.
+class PlacementSolver
+{
+public:
+    enum Outcome
+    {
+        PLACED,             // layout holds a valid placement for every ship
+        INFEASIBLE,         // no valid layout exists
+        UNDECIDED           // the search budget ran out first
+    };
+
+    PlacementSolver(const Game& g, std::pmr::memory_resource* memory = nullptr);
+
+    // Stack buffer big enough for a solve on a standard board.  Bigger
+    // solves spill into a pool kept by each thread, which gets the memory
+    // back when the Scratch goes away.  Spilling into the game's memory
+    // instead would leak into an arena for as long as the game lasts.
+    class Scratch : public std::pmr::monotonic_buffer_resource
+    {
+    public:
+        Scratch();
+    private:
+        char m_buffer[16 * 1024];
+    };
+
+    // No ship may cover p
+    void forbid(Point p);
+    void clearForbidden();
+
+    // shipId must lie entirely within the cells where allowed is true,
+    // indexed r * cols + c.  An empty vector lifts the restriction.
+    void restrictShip(int shipId, const std::pmr::vector<bool>& allowed);
+
+    // If set, ships may not be horizontally or vertically adjacent
+    void setNoTouching(bool noTouching) { m_noTouching = noTouching; }
+
+    Outcome solve(Rng& rng, Layout& layout) const;
+
+    // Place every ship of layout on b; false if any of them doesn't fit
+    static bool apply(const Layout& layout, Board& b);
+
+private:
+    // Fleet is a FixedFleet the game matches, or void
+    template <size_t MaxCells, class Fleet>
+    Outcome solveWith(Rng& rng, Layout& layout) const;
+
+    const Game& m_game;
+    std::pmr::memory_resource* m_memory;
+    std::pmr::vector<char> m_forbidden;                     // cells no ship may cover
+    std::pmr::vector<std::pmr::vector<bool> > m_regions;    // per-ship allowed cells, empty if unrestricted
+    bool m_noTouching;
+};
+
+#endif // PLACEMENTSOLVER_INCLUDED
@@ -0,0 +1,120 @@
+#include "PlacementTable.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+using namespace std;
+
+PlacementTable::PlacementTable(int rows, int cols, const vector<int>& lengths)
+    : m_rows(rows), m_cols(cols), m_lengthOf(lengths.size()), m_coverage(rows * cols, 0)
+{
+    // Group the fleet by ship length
+    for (size_t shipId = 0; shipId < lengths.size(); shipId++)
+    {
+        size_t k = 0;
+        while (k < m_byLength.size() && m_byLength[k].length != lengths[shipId])
+            k++;
+        if (k == m_byLength.size())
+        {
+            LengthTable t;
+            t.length = lengths[shipId];
+            t.multiplicity = 0;
+            t.nHorizontal = (t.length <= cols ? rows * (cols - t.length + 1) : 0);
+            t.nSegments = t.nHorizontal + (t.length <= rows ? (rows - t.length + 1) * cols : 0);
+            m_byLength.push_back(t);
+        }
+        m_byLength[k].multiplicity++;
+        m_lengthOf[shipId] = static_cast<int>(k);
+    }
+
+    for (size_t k = 0; k < m_byLength.size(); k++)
+    {
+        LengthTable& t = m_byLength[k];
+        int shipId = static_cast<int>(find(m_lengthOf.begin(), m_lengthOf.end(), k) - m_lengthOf.begin());
+        if (hasMasks())
+        {
+            t.masks.resize(t.nSegments);
+            t.halos.resize(t.nSegments);
+        }
+        for (int n = 0; n < t.nSegments; n++)
+        {
+            Segment s = segment(shipId, n);
+            for (int j = 0, i = s.start; j < t.length; j++, i += s.stride)
+            {
+                m_coverage[i] += t.multiplicity;
+                if (!hasMasks())
+                    continue;
+                int r = i / cols;
+                int c = i % cols;
+                t.masks[n].set(i);
+                t.halos[n].set(i);
+                if (r > 0)          t.halos[n].set(i - cols);
+                if (r < rows - 1)   t.halos[n].set(i + cols);
+                if (c > 0)          t.halos[n].set(i - 1);
+                if (c < cols - 1)   t.halos[n].set(i + 1);
+            }
+        }
+    }
+}
+
+PlacementTable::Segment PlacementTable::segment(int shipId, int k) const
+{
+    const LengthTable& t = m_byLength[m_lengthOf[shipId]];
+    Segment s;
+    if (k < t.nHorizontal)
+    {
+        int perRow = m_cols - t.length + 1;
+        s.start = (k / perRow) * m_cols + k % perRow;
+        s.stride = 1;
+        s.dir = HORIZONTAL;
+    }
+    else
+    {
+        s.start = k - t.nHorizontal;
+        s.stride = m_cols;
+        s.dir = VERTICAL;
+    }
+    return s;
+}
+
+int PlacementTable::segmentAt(int shipId, Point topOrLeft, Direction dir) const
+{
+    const LengthTable& t = m_byLength[m_lengthOf[shipId]];
+    int r = topOrLeft.r;
+    int c = topOrLeft.c;
+    if (r < 0 || c < 0)
+        return -1;
+    if (dir == HORIZONTAL)
+    {
+        if (r >= m_rows || c + t.length > m_cols)
+            return -1;
+        return r * (m_cols - t.length + 1) + c;
+    }
+    if (r + t.length > m_rows || c >= m_cols)
+        return -1;
+    return t.nHorizontal + r * m_cols + c;
+}
+
+shared_ptr<const PlacementTable> PlacementTable::get(int rows, int cols, const vector<int>& lengths)
+{
+    // Tables are only kept alive by the games using them; the next game of
+    // a configuration nobody is playing any more builds a fresh one
+    static mutex cacheMutex;
+    static map<vector<int>, weak_ptr<const PlacementTable> > cache;
+
+    vector<int> key;
+    key.push_back(rows);
+    key.push_back(cols);
+    key.insert(key.end(), lengths.begin(), lengths.end());
+
+    lock_guard<mutex> lock(cacheMutex);
+    shared_ptr<const PlacementTable> table = cache[key].lock();
+    if (!table)
+    {
+        for (auto it = cache.begin(); it != cache.end(); )
+            it = (it->second.expired() ? cache.erase(it) : next(it));
+        table = make_shared<const PlacementTable>(rows, cols, lengths);
+        cache[key] = table;
+    }
+    return table;
+}
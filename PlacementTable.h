@@ -0,0 +1,79 @@
+#ifndef PLACEMENTTABLE_INCLUDED
+#define PLACEMENTTABLE_INCLUDED
+
+#include "globals.h"
+#include "BitMask.h"
+#include <memory>
+#include <vector>
+
+// Every in-bounds placement of every ship of one fleet on one board size.
+// A table never changes once it is built, and all games with the same
+// rows, columns and ship lengths share one copy, so any number of threads
+// may read it at once.
+//
+// The placements of a ship are numbered with all horizontal ones first,
+// row by row, then all vertical ones, so a placement's number and its
+// origin and direction follow from each other.  On boards of at most
+// SMALL_BOARD_CELLS cells each placement also has its cells as a mask.
+class PlacementTable
+{
+public:
+    typedef BitMask<SMALL_BOARD_CELLS / 64> SmallMask;
+
+    struct Segment
+    {
+        int start;                      // index of the top or left cell
+        int stride;                     // distance between consecutive cells
+        Direction dir;
+    };
+
+    // The shared table for this board size and fleet, built if no game is using one yet
+    static std::shared_ptr<const PlacementTable> get(int rows, int cols, const std::vector<int>& lengths);
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int nShips() const { return static_cast<int>(m_lengthOf.size()); }
+    int shipLength(int shipId) const { return m_byLength[m_lengthOf[shipId]].length; }
+
+    // Distinct ship lengths, each with the number of ships that have it
+    int nLengths() const { return static_cast<int>(m_byLength.size()); }
+    int length(int k) const { return m_byLength[k].length; }
+    int multiplicity(int k) const { return m_byLength[k].multiplicity; }
+
+    int nSegments(int shipId) const { return m_byLength[m_lengthOf[shipId]].nSegments; }
+    Segment segment(int shipId, int k) const;
+
+    // Number of the placement of shipId at topOrLeft, or -1 if it leaves the board
+    int segmentAt(int shipId, Point topOrLeft, Direction dir) const;
+
+    // Masks are only built when hasMasks() is true
+    bool hasMasks() const { return m_rows * m_cols <= SMALL_BOARD_CELLS; }
+    const SmallMask& mask(int shipId, int k) const { return m_byLength[m_lengthOf[shipId]].masks[k]; }
+    // The placement's cells plus every cell sharing an edge with one of them
+    const SmallMask& halo(int shipId, int k) const { return m_byLength[m_lengthOf[shipId]].halos[k]; }
+
+    // Placements of the whole fleet covering cell on an empty board
+    int coverage(int cell) const { return m_coverage[cell]; }
+
+    PlacementTable(int rows, int cols, const std::vector<int>& lengths);
+    PlacementTable(const PlacementTable&) = delete;
+    PlacementTable& operator=(const PlacementTable&) = delete;
+
+private:
+    struct LengthTable
+    {
+        int length;
+        int multiplicity;
+        int nHorizontal;                // placements numbered below this are horizontal
+        int nSegments;
+        std::vector<SmallMask> masks;
+        std::vector<SmallMask> halos;
+    };
+
+    int m_rows, m_cols;
+    std::vector<LengthTable> m_byLength;
+    std::vector<int> m_lengthOf;        // index into m_byLength of each ship
+    std::vector<int> m_coverage;
+};
+
+#endif // PLACEMENTTABLE_INCLUDED
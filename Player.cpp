@@ -2,13 +2,50 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
-#include "utility.h"
+#include "CellSet.h"
+#include "Fleet.h"
+#include "Grid.h"
+#include "HeatMap.h"
+#include "LayoutSampler.h"
+#include "OpeningBook.h"
+#include "PlacementSolver.h"
+#include "PlacementTable.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <stack>
+#include <thread>
+#include <utility>
 
 using namespace std;
 
+//*********************************************************************
+//  Player
+//*********************************************************************
+
+int Player::bookShot(uint64_t stateHash) const
+{
+    const OpeningBook* book = game().openingBook();
+    return book != nullptr ? book->lookup(stateHash) : -1;
+}
+
+bool Player::tryAttack(Point& p, const function<void()>& /* ready */)
+{
+    p = recommendAttack();
+    return true;
+}
+
 //*********************************************************************
 //  AwfulPlayer
 //*********************************************************************
@@ -23,6 +60,7 @@ public:
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
         bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
 private:
     Point m_lastCellAttacked;
 };
@@ -33,6 +71,7 @@ AwfulPlayer::AwfulPlayer(string nm, const Game& g)
 
 bool AwfulPlayer::placeShips(Board& b)
 {
+    PROFILE_SCOPE("awful.placeShips");
     // Clustering ships is bad strategy
     for (int k = 0; k < game().nShips(); k++)
         if (!b.placeShip(Point(k, 0), k, HORIZONTAL))
@@ -42,6 +81,7 @@ bool AwfulPlayer::placeShips(Board& b)
 
 Point AwfulPlayer::recommendAttack()
 {
+    PROFILE_SCOPE("awful.recommendAttack");
     if (m_lastCellAttacked.c > 0)
         m_lastCellAttacked.c--;
     else
@@ -59,6 +99,7 @@ void AwfulPlayer::recordAttackResult(Point /* p */, bool /* validShot */,
     bool /* shotHit */, bool /* shipDestroyed */,
     int /* shipId */)
 {
+    PROFILE_SCOPE("awful.recordAttackResult");
     // AwfulPlayer completely ignores the result of any attack
 }
 
@@ -67,6 +108,11 @@ void AwfulPlayer::recordAttackByOpponent(Point /* p */)
     // AwfulPlayer completely ignores what the opponent does
 }
 
+void AwfulPlayer::reset()
+{
+    m_lastCellAttacked = Point(0, 0);
+}
+
 //*********************************************************************
 //  HumanPlayer
 //*********************************************************************
@@ -80,6 +126,73 @@ bool getLineWithTwoIntegers(int& r, int& c)
     return result;
 }
 
+// Lines typed at the console, for human players in games that must not
+// block.  One thread, started on first use, reads cin and queues each line,
+// so any number of players can wait for input without a thread each.  Once
+// it is in use, nothing else may read cin.
+class ConsoleInput
+{
+public:
+    enum Result { LINE, WAIT, CLOSED };
+
+    static ConsoleInput& instance()
+    {
+        static ConsoleInput input;
+        return input;
+    }
+
+    // Take the next line typed if there is one.  If not, return WAIT and
+    // call ready when a line arrives, or CLOSED if none ever will.
+    Result tryGetLine(string& line, const function<void()>& ready)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_lines.empty())
+        {
+            line = move(m_lines.front());
+            m_lines.pop_front();
+            return LINE;
+        }
+        if (m_closed)
+            return CLOSED;
+        m_waiting.push_back(ready);
+        return WAIT;
+    }
+
+private:
+    ConsoleInput() : m_closed(false)
+    {
+        // Blocked in getline until the program exits, so never joined
+        thread(&ConsoleInput::readLines, this).detach();
+    }
+
+    void readLines()
+    {
+        string line;
+        bool more = true;
+        while (more)
+        {
+            more = static_cast<bool>(getline(cin, line));
+            vector<function<void()> > waiting;
+            {
+                lock_guard<mutex> lock(m_mutex);
+                if (more)
+                    m_lines.push_back(line);
+                else
+                    m_closed = true;
+                waiting.swap(m_waiting);
+            }
+            // Every waiting player looks; those that lose the line wait again
+            for (size_t i = 0; i < waiting.size(); i++)
+                waiting[i]();
+        }
+    }
+
+    mutex m_mutex;
+    deque<string> m_lines;
+    vector<function<void()> > m_waiting;
+    bool m_closed;
+};
+
 // TODO:  You need to replace this with a real class declaration and
 //        implementation.
 class HumanPlayer : public Player
@@ -90,20 +203,23 @@ public:
     virtual bool isHuman() const { return true; }
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
+    virtual bool tryAttack(Point& p, const function<void()>& ready);
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
         bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
 private:
+    bool m_prompted;                            // asked for the shot tryAttack is waiting for
     Point m_attackCell;
     Point m_placeShip;
     int current_shipId;
     Direction current_dir;
-    bool hasOwnShip[MAXROWS][MAXCOLS];          // Record if player has previously placed a ship in a given position on the board
+    Grid<bool> hasOwnShip;                      // Record if player has previously placed a ship in a given position on the board
     vector <Point> chosen_points;               // Stores previously chosen points player has attacked
 };
 
 HumanPlayer::HumanPlayer(string nm, const Game& g)
-    : Player(nm, g), m_attackCell(0, 0), m_placeShip(0, 0), current_shipId(-1), current_dir(HORIZONTAL), hasOwnShip()
+    : Player(nm, g), m_prompted(false), m_attackCell(0, 0), m_placeShip(0, 0), current_shipId(-1), current_dir(HORIZONTAL), hasOwnShip(g.rows(), g.cols())
 {}
 
 HumanPlayer::~HumanPlayer()
@@ -190,24 +306,56 @@ bool HumanPlayer::placeShips(Board& b)
 
 Point HumanPlayer::recommendAttack()
 {
-    // Prompt human for attack position
+    // Prompt human for attack position until the input is made of 2 integers
 
-    cout << "Enter the row andd column to attack (e.g., 3 5): ";
     int r, c;
-    bool integer = getLineWithTwoIntegers(r, c);
+    while (true)
+    {
+        cout << "Enter the row andd column to attack (e.g., 3 5): ";
+        if (getLineWithTwoIntegers(r, c))
+            break;
+        cout << "You must enter two integers. " << endl;
+    }
 
+    chosen_points.push_back(Point(r, c));           // Record attack at inputted position
 
+    return Point(r, c);                             // Return valid inputted position
+}
 
-    // If input is not made of 2 integerss
-    if (!integer)
+bool HumanPlayer::tryAttack(Point& p, const function<void()>& ready)
+{
+    // As recommendAttack, taking whatever lines have been typed so far
+    string line;
+    int r, c;
+    while (true)
     {
+        if (!m_prompted)
+        {
+            cout << "Enter the row andd column to attack (e.g., 3 5): ";
+            cout.flush();
+            m_prompted = true;
+        }
+
+        ConsoleInput::Result got = ConsoleInput::instance().tryGetLine(line, ready);
+        if (got == ConsoleInput::WAIT)
+            return false;
+        m_prompted = false;
+        if (got == ConsoleInput::CLOSED)
+        {
+            // Nobody is left to answer: waste the shot so the game still ends
+            r = -1;
+            c = -1;
+            break;
+        }
+        istringstream in(line);
+        if (in >> r >> c)
+            break;
         cout << "You must enter two integers. " << endl;
-        return recommendAttack();
     }
 
     chosen_points.push_back(Point(r, c));           // Record attack at inputted position
-
-    return Point(r, c);                             // Return valid inputted position
+    p = Point(r, c);
+    return true;
 }
 
 void HumanPlayer::recordAttackResult(Point /* p */, bool /* validShot */, bool /* shotHit */, bool /* shipDestroyed */, int /* shipId */)
@@ -220,6 +368,17 @@ void HumanPlayer::recordAttackByOpponent(Point /* p */)
     // HumanPlayer completely ignores what the opponent does
 }
 
+void HumanPlayer::reset()
+{
+    m_prompted = false;
+    m_attackCell = Point(0, 0);
+    m_placeShip = Point(0, 0);
+    current_shipId = -1;
+    current_dir = HORIZONTAL;
+    hasOwnShip.fill(false);
+    chosen_points.clear();
+}
+
 //*********************************************************************
 //  MediocrePlayer
 //*********************************************************************
@@ -231,169 +390,84 @@ class MediocrePlayer : public Player
 public:
     MediocrePlayer(string nm, const Game& g);
     ~MediocrePlayer() {}
-    // Determine where to place each ship
-    bool placeShip(Point p, int shipId, Board& b, int tries);
-    // If current ship configuration doesn't work, unplace all previously placed ships 
-    bool backTrack(int current_shipId, size_t index, Board& b);
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
         bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
 private:
     Point m_attackCell;
     int state;
-    bool hasHit[MAXROWS][MAXCOLS];                  // Record if ship has been hit at each position on board
-    vector <Point> close_points;                    // Store current list of points within 4 steps of hit point both vertically and horizontally
-    vector <Point> unChosen_coordinates;            // Store all points on board not yet attacked
-    vector <Point> Chosen_coordinates;              // Store all points on board previously attacked
-    vector <Point> unused_coordinates;              // Store all points without a placed ship
-    vector <Point> used_coordinates;                // Store all points with a placed ship
+    Grid<bool> hasHit;                              // Record if ship has been hit at each position on board
+    CellSet close_points;                           // Store current set of unattacked cells within 4 steps of hit point both vertically and horizontally
+    CellSet unChosen_coordinates;                   // Store all cells on board not yet attacked
     Point start_point;                              // Record hit location for close_points to reference
 
 };
 
-MediocrePlayer::MediocrePlayer(string nm, const Game& g) :Player(nm, g), state(0), close_points(), unChosen_coordinates()
-{
-    // Record each point in the board as unChosen, unused, and not hit
-    for (int r = 0; r < game().rows(); r++)
-        for (int c = 0; c < game().cols(); c++)
-        {
-            unChosen_coordinates.push_back(Point(r, c));
-            unused_coordinates.push_back(Point(r, c));
-            hasHit[r][c] = false;
-        }
-}
-
-bool MediocrePlayer::backTrack(int current_shipId, size_t index, Board& b)
-{
-    // If we've examined all used coordinates, return false
-    if (index >= used_coordinates.size())
-        return false;
-
-    // If all ships are removed, return true
-    if (current_shipId == -1)
-        return true;
-
-    // If inputted ship can be unplaced at current position, move to next ship and next location
-    if (b.unplaceShip(used_coordinates.at(index), current_shipId, VERTICAL) || b.unplaceShip(used_coordinates.at(index), current_shipId, HORIZONTAL))
-        return backTrack(current_shipId - 1, index + 1, b);
-
-    // If inputted ship cannot be unplaced at current position, try again at next location
-    return backTrack(current_shipId, index + 1, b);
-}
-
-bool MediocrePlayer::placeShip(Point p, int shipId, Board& b, int tries)
+MediocrePlayer::MediocrePlayer(string nm, const Game& g)
+    : Player(nm, g), state(0), hasHit(g.rows(), g.cols(), g.memory()),
+      close_points(g.rows() * g.cols(), g.memory()), unChosen_coordinates(g.rows() * g.cols(), g.memory())
 {
-
-    // If all ships have been placed, return true
-    if (shipId == game().nShips())
-        return true;
-
-    // If the last unused coordinate has been reached
-    if (unused_coordinates.size() == 0)
-    {
-        // If no ships have been placed, return false
-        if (shipId == 0)
-            return false;
-
-        // If we've used all unused coordinates 50 times, return false
-        if (tries >= 50)
-            return false;
-
-        // If we backTrack fails, return false
-        if (!backTrack(shipId, 0, b))
-            return false;
-
-        // All positions in board are now unused and no positions are used
-        for (size_t i = 0; i < used_coordinates.size(); i++)
-            unused_coordinates.push_back(used_coordinates.at(i));
-        used_coordinates.clear();
-
-        // Pick a random coordinate to start placing ships at again from scratch, but record the try that has taken place
-        int index = randInt(static_cast<int>(unused_coordinates.size()));
-        return placeShip(unused_coordinates.at(index), shipId, b, tries + 1);
-    }
-
-    if (b.placeShip(p, shipId, VERTICAL) || b.placeShip(p, shipId, HORIZONTAL))
-    {
-        // Free up all positions in the board to attempt to place the next ship
-        for (size_t i = 0; i < used_coordinates.size(); i++)
-            unused_coordinates.push_back(used_coordinates.at(i));
-        used_coordinates.clear();
-
-        // If possible, place ship at inputted location and proceed to place next ship
-        int rand_index = randInt(static_cast<int>(unused_coordinates.size()));
-        return placeShip(unused_coordinates.at(rand_index), shipId + 1, b, tries);
-    }
-
-    // Coordinate has now been used
-    used_coordinates.push_back(p);
-    eraseFromVector(p.r, p.c, unused_coordinates);
-
-    if (unused_coordinates.size() > 0)
-    {
-        // If ship could not be placed, try a different coordinate
-        int index = randInt(static_cast<int>(unused_coordinates.size()));
-        return placeShip(unused_coordinates.at(index), shipId, b, tries);
-    }
-
-    // If the function has used the last unused coordinate on the board
-    else
-        return placeShip(Point(-1, -1), shipId, b, tries);
-
-
-
+    // Record each point in the board as unChosen and not hit
+    unChosen_coordinates.fill();
+    hasHit.fill(false);
 }
 
 bool MediocrePlayer::placeShips(Board& b)
 {
+    PROFILE_SCOPE("mediocre.placeShips");
     // Make sure there's enough area in the board to place all ships
     int total_area_ships = 0;
     for (int id = 0; id < game().nShips(); id++)
         total_area_ships += game().shipLength(id);
 
-    int total_area_blockedBoard = int(0.5 * game().rows() * game().cols());
+    int num_cells = game().rows() * game().cols();
+    int total_area_blockedBoard = int(0.5 * num_cells);
     if (total_area_blockedBoard < total_area_ships)
         return false;
 
-    for (int i = 0; i < game().nShips(); i++)
-        if (game().shipLength(i) >= game().cols() && game().shipLength(i) >= game().rows())
-            return false;
-
-    b.block();                          // Block half the cells on the board
-
-
-    // Start the placeShip function at a random cell on the board
-    int index = randInt(static_cast<int>(unused_coordinates.size()));
-    bool set = placeShip(unused_coordinates.at(index), 0, b, 0);
+    // Block a random half of the board and fit the fleet in the other half.
+    // If this blocking leaves no room, block a different half, up to 50 times.
+    PlacementSolver::Scratch scratch;
+    PlacementSolver solver(game(), &scratch);
+    pmr::vector<int> cells(num_cells, &scratch);
+    Layout layout(&scratch);
+    for (int tries = 0; tries < 50; tries++)
+    {
+        for (int i = 0; i < num_cells; i++)
+            cells[i] = i;
+        game().rng().shuffle(cells.begin(), cells.end());
 
-    b.unblock();                        // Unblock all blocked cells on the board
+        solver.clearForbidden();
+        for (int i = 0; i < num_cells / 2; i++)
+            solver.forbid(Point(cells[i] / game().cols(), cells[i] % game().cols()));
 
-    return set;
+        if (solver.solve(game().rng(), layout) == PlacementSolver::PLACED)
+            return PlacementSolver::apply(layout, b);
+    }
+    return false;
 }
 
 Point MediocrePlayer::recommendAttack()
 {
+    PROFILE_SCOPE("mediocre.recommendAttack");
     if (state == 0)
     {
         // If ship hasn't been hit without destroying ship, return a random unchosen coordinate
-        int index = randInt(static_cast<int>(unChosen_coordinates.size()));
-        Point current(unChosen_coordinates.at(index));
-        Chosen_coordinates.push_back(current);
-        eraseFromVector(current.r, current.c, unChosen_coordinates);
-        return current;
+        int cell = unChosen_coordinates.random(game().rng());
+        unChosen_coordinates.erase(cell);
+        return Point(cell / game().cols(), cell % game().cols());
     }
 
     else
     {
         // If ship has been hit and a ship hasn't been destroyed, return a random unchosen coordinate within 4 steps of original hit
-        int index = randInt(static_cast<int>(close_points.size()));
-        Point current = close_points.at(index);
-        Chosen_coordinates.push_back(current);
-        eraseFromVector(current.r, current.c, close_points);
-        eraseFromVector(current.r, current.c, unChosen_coordinates);
-        return current;
+        int cell = close_points.random(game().rng());
+        close_points.erase(cell);
+        unChosen_coordinates.erase(cell);
+        return Point(cell / game().cols(), cell % game().cols());
     }
 
 }
@@ -402,6 +476,7 @@ Point MediocrePlayer::recommendAttack()
 void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
     bool shipDestroyed, int /* shipId */)
 {
+    PROFILE_SCOPE("mediocre.recordAttackResult");
     // If attack uhas an invalid coordinate, stop the function
     if (!validShot)
         return;
@@ -410,28 +485,24 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
     {
         // For all cases where shot was hit, record the event
         if (shotHit)
-            hasHit[p.r][p.c] = true;
+            hasHit(p.r, p.c) = true;
 
 
         if (shotHit && !shipDestroyed)
         {
-            // If shot hit but ship wasn't destroyed, record point and make list of 
-            // coordinates within 4 steps of inputted location
+            // If shot hit but ship wasn't destroyed, record point and make set of
+            // unchosen coordinates within 4 steps of inputted location
             start_point = p;
             close_points.clear();
 
+            int cols = game().cols();
             for (int i = p.r - 4; i <= (p.r + 4); i++)
-                if (game().isValid(Point(i, p.c)))
-                    close_points.push_back(Point(i, p.c));
+                if (game().isValid(Point(i, p.c)) && unChosen_coordinates.contains(i * cols + p.c))
+                    close_points.insert(i * cols + p.c);
 
             for (int i = p.c - 4; i <= (p.c + 4); i++)
-                if (game().isValid(Point(p.r, i)))
-                    close_points.push_back(Point(p.r, i));
-
-            for (size_t i = 0; i < Chosen_coordinates.size(); i++)
-                for (size_t j = 0; j < close_points.size(); j++)
-                    if (Chosen_coordinates.at(i).r == close_points.at(j).r && Chosen_coordinates.at(i).c == close_points.at(j).c)
-                        eraseFromVector(close_points.at(j).r, close_points.at(j).c, close_points);
+                if (game().isValid(Point(p.r, i)) && unChosen_coordinates.contains(p.r * cols + i))
+                    close_points.insert(p.r * cols + i);
 
             state = 1;              // Record change in state
         }
@@ -441,11 +512,11 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
     {
         if (shotHit && !shipDestroyed)
         {
-            hasHit[p.r][p.c] = true;            // Record hit shot
+            hasHit(p.r, p.c) = true;            // Record hit shot
         }
         if (shotHit && shipDestroyed)
         {
-            hasHit[p.r][p.c] = true;
+            hasHit(p.r, p.c) = true;
             state = 0;
         }
         if (close_points.size() == 0)           // All close points have been attacked
@@ -460,6 +531,15 @@ void MediocrePlayer::recordAttackByOpponent(Point /* p */)
     // This function does nothing
 }
 
+void MediocrePlayer::reset()
+{
+    // Back to random shots with every cell unchosen and not hit
+    state = 0;
+    hasHit.fill(false);
+    close_points.clear();
+    unChosen_coordinates.fill();
+}
+
 
 
 //*********************************************************************
@@ -473,9 +553,6 @@ class GoodPlayer : public Player
 public:
     GoodPlayer(string nm, const Game& g);
     ~GoodPlayer() {}                                            // delete player subclass destructors next
-    bool placeShipsRestricted(int shipId, Board& b, int tries); // Back-up to placeRestOfShips
-    bool placeRestOfShips(int shipId, Board& b, int tries);     // Place all ships so that none neighbour each other
-    int num_possible_ships(int r, int c) const;                 // Count number of ship location possibilities at each location
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
     Point chooseNextFree();                                     // Return unchosen position with most ship possibilities
@@ -483,340 +560,81 @@ public:
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
         bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
-    void eraseNeighbouringPoints(Point start, int shipId, Direction dir);       // Remove all points containing or neighbouring a ship from unused_coordinates vector
+    virtual void reset();
 private:
     int state;
-    bool hasOwnShip[MAXROWS][MAXCOLS];
-    bool hasHit[MAXROWS][MAXCOLS];
-    bool hasMissed[MAXROWS][MAXCOLS];
-    vector<Point> unused_coordinates;               // Store all points without a ship and not neighbouring a placed ship
-    vector<Point> used_coordinates;                 // Store all points either containing a ship or neighbouring a ship
-    vector<Point> unChosen_coordinates;
+    Grid<bool> hasHit;
+    Grid<bool> hasMissed;
+    CellSet unChosen_coordinates;
+    HeatMap heat;                                   // Placement counts over the cells not yet attacked
     int closeDirections;
     Point start_point;
     int r_cur, c_cur;                               // First hit but not destroyed position to anchor chooseClose outcomes
+    uint64_t stateHash;                             // Zobrist hash of every shot result so far, for the opening book
 };
 
-GoodPlayer::GoodPlayer(string nm, const Game& g) : Player(nm, g), state(0), closeDirections(0), r_cur(-1), c_cur(-1)
+GoodPlayer::GoodPlayer(string nm, const Game& g)
+    : Player(nm, g), state(0), hasHit(g.rows(), g.cols(), g.memory()), hasMissed(g.rows(), g.cols(), g.memory()),
+      unChosen_coordinates(g.rows() * g.cols(), g.memory()), heat(g), closeDirections(0), r_cur(-1), c_cur(-1), stateHash(0)
 {
     // Initialize each cell in the board as empty without any history
-    for (int r = 0; r < game().rows(); r++)
-        for (int c = 0; c < game().cols(); c++)
-        {
-            hasOwnShip[r][c] = false;
-            unused_coordinates.push_back(Point(r, c));
-            unChosen_coordinates.push_back(Point(r, c));
-            hasMissed[r][c] = false;
-            hasHit[r][c] = false;
-        }
-}
-
-bool GoodPlayer::placeShipsRestricted(int shipId, Board& b, int tries)
-{
-    // If ships cannot be placed without neighbours, place them randomly in the board
-
-    // Function has placed all the ships
-    if (shipId == game().nShips())
-        return true;
-
-    // All coordinates have ships on them
-    if (unused_coordinates.size() == 0)
-        return false;
-
-    // Function has unsuccessfully tried to place ships too many times
-    if (tries >= MAXROWS * MAXCOLS * 2)
-        return false;
-
-    // Choose a random shipless point
-    int random = randInt(static_cast<int>(unused_coordinates.size()));
-    Point random_point = unused_coordinates.at(random);
-
-    // Place ship horizontally or vertically if possible
-
-    if (/*shipVertical && */ b.placeShip(random_point, shipId, VERTICAL))
-    {
-        for (int r = random_point.r; r < (random_point.r + game().shipLength(shipId)); r++)
-            eraseFromVector(r, random_point.c, unused_coordinates);
-        return placeShipsRestricted(shipId + 1, b, tries);
-    }
-    if (/*shipHorizontal &&*/ b.placeShip(random_point, shipId, HORIZONTAL))
-    {
-        for (int c = random_point.c; c < (random_point.c + game().shipLength(shipId)); c++)
-            eraseFromVector(random_point.r, c, unused_coordinates);
-        return placeShipsRestricted(shipId + 1, b, tries);
-    }
-
-    // If ship was not placed, try again with a different coordinate
-    return placeRestOfShips(shipId, b, tries + 1);
-
-}
-
-bool GoodPlayer::placeRestOfShips(int shipId, Board& b, int tries)
-{
-    // All ships have been placed on the board
-    if (shipId == game().nShips())
-        return true;
-
-    // All unused coordinates have been used
-    if (unused_coordinates.size() == 0)
-        return false;
-
-    // We've unsuccessfully tried to place ships too many times
-    if (tries >= MAXROWS * MAXCOLS * 2)
-    {
-        b.clear();
-        used_coordinates.clear();
-        unused_coordinates.clear();
-        for (int r = 0; r < game().rows(); r++)
-            for (int c = 0; c < game().cols(); c++)
-                unused_coordinates.push_back(Point(r, c));
-        return placeShipsRestricted(0, b, 0);
-    }
-
-    // Pick a random point that doesn't have a ship on it
-    int random = randInt(static_cast<int>(unused_coordinates.size()));
-    Point random_point = unused_coordinates.at(random);
-
-    // Determine if current ship can be placed at random point vertically
-    bool shipVertical = true;
-    bool shipHorizontal = true;
-
-    for (int r = random_point.r - 1; r <= random_point.r + game().shipLength(shipId); r++)
-        for (size_t i = 0; i < used_coordinates.size(); i++)
-            if (used_coordinates.at(i).r == r && used_coordinates.at(i).c == random_point.c)
-            {
-                shipVertical = false;
-            }
-
-    // Determine if current ship can be placed at random point horizontally
-
-    for (int c = random_point.c - 1; c <= random_point.c + game().shipLength(shipId); c++)
-        for (size_t i = 0; i < used_coordinates.size(); i++)
-            if (used_coordinates.at(i).r == random_point.r && used_coordinates.at(i).c == c)
-            {
-                shipHorizontal = false;
-            }
-
-    // Place ship horizontally or vertically if possible
-
-    bool placedVertical = false;
-    bool placedHorizontal = false;
-
-    if ((shipVertical && b.placeShip(random_point, shipId, VERTICAL)))
-    {
-        eraseNeighbouringPoints(random_point, shipId, VERTICAL);
-        placedVertical = true;
-    }
-    if (shipHorizontal && b.placeShip(random_point, shipId, HORIZONTAL))
-    {
-        eraseNeighbouringPoints(random_point, shipId, HORIZONTAL);
-        placedHorizontal = true;
-    }
-
-    // If ship was placed, move on to next ship
-    if (placedHorizontal || placedVertical)
-        return placeRestOfShips(shipId + 1, b, tries + 1);
-
-    // If ship was not placed, try again with a different coordinate
-    return placeRestOfShips(shipId, b, tries + 1);
-
-}
-
-void GoodPlayer::eraseNeighbouringPoints(Point start, int shipId, Direction dir)
-{
-    // Erase all points containing or neighbouring inputted ship at inputted location
-
-    if (dir == HORIZONTAL)
-    {
-        for (int i = start.c; i < (start.c + game().shipLength(shipId)); i++)
-        {
-            hasOwnShip[start.r][i] = true;
-            used_coordinates.push_back(Point(start.r, i));
-            used_coordinates.push_back(Point(start.r + 1, i));
-            used_coordinates.push_back(Point(start.r - 1, i));
-            eraseFromVector(start.r, i, unused_coordinates);
-            eraseFromVector(start.r + 1, i, unused_coordinates);
-            eraseFromVector(start.r - 1, i, unused_coordinates);
-        }
-        used_coordinates.push_back(Point(start.r, start.c - 1));
-        used_coordinates.push_back(Point(start.r, start.c + game().shipLength(shipId)));
-        eraseFromVector(start.r, start.c - 1, unused_coordinates);
-        eraseFromVector(start.r, start.c + game().shipLength(shipId), unused_coordinates);
-    }
-    else
-    {
-        for (int i = start.r; i < (start.r + game().shipLength(shipId)); i++)
-        {
-            hasOwnShip[i][start.c] = true;
-            used_coordinates.push_back(Point(i, start.c));
-            used_coordinates.push_back(Point(i, start.c + 1));
-            used_coordinates.push_back(Point(i, start.c - 1));
-            eraseFromVector(i, start.c, unused_coordinates);
-            eraseFromVector(i, start.c + 1, unused_coordinates);
-            eraseFromVector(i, start.c - 1, unused_coordinates);
-        }
-        used_coordinates.push_back(Point(start.r - 1, start.c));
-        used_coordinates.push_back(Point(start.r + game().shipLength(shipId), start.c));
-        eraseFromVector(start.r - 1, start.c, unused_coordinates);
-        eraseFromVector(start.r + game().shipLength(shipId), start.c, unused_coordinates);
-    }
+    unChosen_coordinates.fill();
+    hasMissed.fill(false);
+    hasHit.fill(false);
 }
 
 bool GoodPlayer::placeShips(Board& b)
 {
+    PROFILE_SCOPE("good.placeShips");
     // If no ships to place, return true
     if (game().nShips() <= 0)
         return true;
 
-    // If one ship doesn't fit in board, return false
-    for (int i = 0; i < game().nShips(); i++)
-        if (game().shipLength(i) >= game().cols() && game().shipLength(i) >= game().rows())
-            return false;
-
-    // If ships have a larger area than board, return false
+    // Place the first ship along a side of the board and keep every ship
+    // from neighbouring another.  If that's impossible, drop the side rule,
+    // then the neighbour rule.  The solver rejects fleets that can't fit at all.
 
-    int total_area_ships = 0;
-    for (int id = 0; id < game().nShips(); id++)
-        total_area_ships += game().shipLength(id);
+    PlacementSolver::Scratch scratch;
+    pmr::vector<bool> border(game().rows() * game().cols(), false, &scratch);
+    for (int r = 0; r < game().rows(); r++)
+        for (int c = 0; c < game().cols(); c++)
+            border[r * game().cols() + c] = (r == 0 || c == 0 || r == game().rows() - 1 || c == game().cols() - 1);
 
-    int total_area_board = int(game().rows() * game().cols());
-    if (total_area_board < total_area_ships)
-        return false;
+    PlacementSolver solver(game(), &scratch);
+    Layout layout(&scratch);
 
-    // Place first ship on random side of board
+    solver.setNoTouching(true);
+    solver.restrictShip(0, border);
+    if (solver.solve(game().rng(), layout) == PlacementSolver::PLACED)
+        return PlacementSolver::apply(layout, b);
 
-    // Let top, right, bottom, left = 0,1,2,3
-    int side = randInt(4);
-    int col, row;
-    switch (side)
-    {
-    case 0:         // top          
-        col = randInt(game().cols() - game().shipLength(0));
-        if (b.placeShip(Point(0, col), 0, HORIZONTAL))
-        {
-            eraseNeighbouringPoints(Point(0, col), 0, HORIZONTAL);
-            break;
-        }
-        else
-        {
-            ;
-        }
-    case 1:         // right
-        row = randInt(game().rows() - game().shipLength(0));
-        if (b.placeShip(Point(row, 0), 0, VERTICAL))
-        {
-            eraseNeighbouringPoints(Point(row, 0), 0, VERTICAL);
-            break;
-        }
-        else
-        {
-            ;
-        }
-    case 2:         // bottom
-        col = randInt(game().cols() - game().shipLength(0));
-        if (b.placeShip(Point(game().rows() - 1, col), 0, HORIZONTAL))
-        {
-            eraseNeighbouringPoints(Point(game().rows() - 1, col), 0, HORIZONTAL);
-            break;
-        }
-        else
-        {
-            ;
-        }
-    case 3:         // left
-        row = randInt(game().rows() - game().shipLength(0));
-        if (b.placeShip(Point(row, game().cols() - 1), 0, VERTICAL))
-        {
-            eraseNeighbouringPoints(Point(row, game().cols() - 1), 0, VERTICAL);
-            break;
-        }
-        else
-        {
-            col = randInt(game().cols() - game().shipLength(0));
-            if (b.placeShip(Point(0, col), 0, HORIZONTAL))
-            {
-                eraseNeighbouringPoints(Point(0, col), 0, HORIZONTAL);
-                break;
-            }
-            else
-            {
-                ;
-            }
-        }
-    }
+    solver.restrictShip(0, pmr::vector<bool>());
+    if (solver.solve(game().rng(), layout) == PlacementSolver::PLACED)
+        return PlacementSolver::apply(layout, b);
 
-    // If more ships to play
-    if (game().nShips() > 1)
-        return placeRestOfShips(1, b, 0);
+    solver.setNoTouching(false);
+    if (solver.solve(game().rng(), layout) == PlacementSolver::PLACED)
+        return PlacementSolver::apply(layout, b);
 
-    return true;        // Ships successfully placed
+    return false;
 }
 
 
-int GoodPlayer::num_possible_ships(int r, int c) const
-{
-    // Count number of possible ship configurations at inputted location while treating hit ships as misses
-
-    // For each ship, count the number of horizontal and vertical possibilities and add them together
-
-    int combination_count = 0;
-
-    for (int shipId = 0; shipId < game().nShips(); shipId++)
-    {
-        for (int cur_row = (r - game().shipLength(shipId) + 1); cur_row <= r; cur_row++)
-        {
-            if (cur_row >= 0 && cur_row < game().rows() && (cur_row + game().shipLength(shipId) - 1) < game().rows())
-            {
-                ++combination_count;
-                for (int row = cur_row; row < (cur_row + game().shipLength(shipId)); row++)
-                    if (hasMissed[row][c] || hasHit[row][c])
-                    {
-                        --combination_count;
-                        break;
-                    }
-            }
-        }
-
-        for (int cur_col = (c - game().shipLength(shipId) + 1); cur_col <= c; cur_col++)
-        {
-            if (cur_col >= 0 && cur_col < game().cols() && (cur_col + game().shipLength(shipId) - 1) < game().cols())
-            {
-                ++combination_count;
-                for (int col = cur_col; col < (cur_col + game().shipLength(shipId)); col++)
-                    if (hasMissed[r][col] || hasHit[r][col])
-                    {
-                        --combination_count;
-                        break;
-                    }
-            }
-        }
-    }
-    return combination_count;       // Return total number of possibilities for inputted location
-}
-
 Point GoodPlayer::chooseNextFree()
 {
-    // Iterate through each point on the board and find the location with the largest ship possibilities
-
-    int max_possibilities = 0;
-    Point max(-1, -1);
+    // Early in the game the opening book may already have the answer
+    int cell = bookShot(stateHash);
+    if (cell >= 0 && unChosen_coordinates.contains(cell))
+        return Point(cell / game().cols(), cell % game().cols());
 
-    for (size_t i = 0; i < unChosen_coordinates.size(); i++)
-    {
-        int possibilities = num_possible_ships(unChosen_coordinates.at(i).r, unChosen_coordinates.at(i).c);
-        if (possibilities > max_possibilities)
-        {
-            max_possibilities = possibilities;
-            max.r = unChosen_coordinates.at(i).r;
-            max.c = unChosen_coordinates.at(i).c;
-        }
-    }
+    // The heat map keeps track of the location with the largest ship possibilities
+    Point max;
 
     // Special case of few spaces left
-    if (max_possibilities == 0)
+    if (!heat.best(max))
     {
-        int random_point = randInt(static_cast<int>(unChosen_coordinates.size()));
-        return unChosen_coordinates.at(random_point);
+        int cell = unChosen_coordinates.random(game().rng());
+        return Point(cell / game().cols(), cell % game().cols());
     }
 
     return max;             // Retrun the location with the largest amount of ship possibilities
@@ -831,10 +649,10 @@ Point GoodPlayer::chooseClose(int r, int c, int dir)
     {
     case 4:                             // Left
         current = Point(r, c - 1);
-        if (game().isValid(current) && !hasMissed[r][c - 1])
+        if (game().isValid(current) && !hasMissed(r, c - 1))
         {
             // If neighbouring position has been hit, re-run function with next position in the left direction
-            if (hasHit[r][c - 1])
+            if (hasHit(r, c - 1))
                 return chooseClose(r, c - 1, closeDirections);
             else
                 return current;
@@ -845,10 +663,10 @@ Point GoodPlayer::chooseClose(int r, int c, int dir)
         }
     case 3:                             // Right
         current = Point(r, c + 1);
-        if (game().isValid(current) && !hasMissed[r][c + 1])
+        if (game().isValid(current) && !hasMissed(r, c + 1))
         {
             // If neighbouring position has been hit, re-run function with next position in the right direction
-            if (hasHit[r][c + 1])
+            if (hasHit(r, c + 1))
                 return chooseClose(r, c + 1, closeDirections);
             else
                 return current;
@@ -859,10 +677,10 @@ Point GoodPlayer::chooseClose(int r, int c, int dir)
         }
     case 2:                             // Up
         current = Point(r - 1, c);
-        if (game().isValid(current) && !hasMissed[r - 1][c])
+        if (game().isValid(current) && !hasMissed(r - 1, c))
         {
             // If neighbouring position has been hit, re-run function with next position in the upwards direction
-            if (hasHit[r - 1][c])
+            if (hasHit(r - 1, c))
                 return chooseClose(r - 1, c, closeDirections);
             else
                 return current;
@@ -873,10 +691,10 @@ Point GoodPlayer::chooseClose(int r, int c, int dir)
         }
     case 1:                             // Down
         current = Point(r + 1, c);
-        if (game().isValid(current) && !hasMissed[r + 1][c])
+        if (game().isValid(current) && !hasMissed(r + 1, c))
         {
             // If neighbouring position has been hit, re-run function with next position in the downwards direction
-            if ((hasHit[r + 1][c]))
+            if ((hasHit(r + 1, c)))
                 return chooseClose(r + 1, c, closeDirections);
             else
                 return current;
@@ -894,6 +712,7 @@ Point GoodPlayer::chooseClose(int r, int c, int dir)
 
 Point GoodPlayer::recommendAttack()
 {
+    PROFILE_SCOPE("good.recommendAttack");
     // Ship was just hit
     if (state == 0)
         return chooseNextFree();
@@ -905,25 +724,29 @@ Point GoodPlayer::recommendAttack()
 
 
 void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
-    bool shipDestroyed, int /* shipId */)
+    bool shipDestroyed, int shipId)
 {
+    PROFILE_SCOPE("good.recordAttackResult");
     if (!validShot)
         return;
 
-    eraseFromVector(p.r, p.c, unChosen_coordinates);        // Record inputted position
+    // Record inputted position, and its result if it's new
+    if (unChosen_coordinates.erase(p.r * game().cols() + p.c))
+        stateHash ^= Zobrist::shot(p.r * game().cols() + p.c, shotHit, shipDestroyed, shipId);
+    heat.markShot(p);
 
     if (state == 0)
     {
         // Record events of all possible outcomes
 
         if (!shotHit)
-            hasMissed[p.r][p.c] = true;
+            hasMissed(p.r, p.c) = true;
 
         if (shotHit && !shipDestroyed)
         {
             state = 1;
             start_point = p;
-            hasHit[p.r][p.c] = true;
+            hasHit(p.r, p.c) = true;
             closeDirections = 4;        // Represents 4 currently unexplored directions from new anchor point
             r_cur = p.r;                // chooseClose anchor point
             c_cur = p.c;
@@ -931,7 +754,7 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
 
         if (shipDestroyed)
         {
-            hasHit[p.r][p.c] = true;
+            hasHit(p.r, p.c) = true;
         }
 
     }
@@ -943,19 +766,19 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
         if (shotHit && shipDestroyed)
         {
             state = 0;
-            hasHit[p.r][p.c] = true;
+            hasHit(p.r, p.c) = true;
         }
 
         if (!shotHit && closeDirections == 0)
         {
             --closeDirections;                  // No more directions to explore. Back to state 0
-            hasMissed[p.r][p.c] = true;
+            hasMissed(p.r, p.c) = true;
             state = 0;
         }
 
         if (!shotHit && closeDirections > 0)
         {
-            hasMissed[p.r][p.c] = true;
+            hasMissed(p.r, p.c) = true;
             --closeDirections;                  // Time to explore next direction
             r_cur = start_point.r;
             c_cur = start_point.c;
@@ -963,7 +786,7 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
         }
 
         if (shotHit && !shipDestroyed)
-            hasHit[p.r][p.c] = true;
+            hasHit(p.r, p.c) = true;
     }
 }
 
@@ -972,27 +795,988 @@ void GoodPlayer::recordAttackByOpponent(Point /* p */)
     // do nothing
 }
 
+void GoodPlayer::reset()
+{
+    // Every cell empty without any history, as after construction
+    state = 0;
+    unChosen_coordinates.fill();
+    hasMissed.fill(false);
+    hasHit.fill(false);
+    heat.reset();
+    closeDirections = 0;
+    r_cur = -1;
+    c_cur = -1;
+    stateHash = 0;
+}
+
 
 
 //*********************************************************************
-//  createPlayer
+//  MonteCarloPlayer
 //*********************************************************************
 
-Player* createPlayer(string type, string nm, const Game& g)
+// Samples many complete fleet layouts that agree with every hit, miss and
+// sunk ship seen so far and fires at the unknown cell that is occupied in
+// the most samples.  Sampling is split into chunks, each with its own
+// generator seeded from the game, and the chunks run on the shared thread
+// pool.  The chosen shot depends only on the game's seed, not on how many
+// threads did the work.
+class MonteCarloPlayer : public Player
 {
-    static string types[] = {
-        "human", "awful", "mediocre", "good"
-    };
-
-    int pos;
-    for (pos = 0; pos != sizeof(types) / sizeof(types[0]) && type != types[pos]; pos++)
-        ;
-    switch (pos)
+public:
+    MonteCarloPlayer(string nm, const Game& g, int samples, int threads);
+    ~MonteCarloPlayer() {}
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+        bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+private:
+    // Draw up to nSamples layouts and add the occupancy of each accepted one to m_counts
+    void sampleChunk(uint64_t seed, int nSamples);
+
+    static constexpr int MAX_CHUNKS = 64;
+
+    int m_samples;                          // layouts drawn per shot
+    int m_threads;                          // threads used for sampling, 0 for the whole pool
+    LayoutSampler m_sampler;                // everything seen of the opponent's board
+    CellSet m_unknown;                      // cells not yet attacked
+    pmr::vector<atomic<int> > m_counts;     // samples in which each cell was occupied
+};
+
+MonteCarloPlayer::MonteCarloPlayer(string nm, const Game& g, int samples, int threads)
+    : Player(nm, g), m_samples(samples), m_threads(threads), m_sampler(g),
+      m_unknown(g.rows() * g.cols(), g.memory()), m_counts(g.rows() * g.cols(), g.memory())
+{
+    m_unknown.fill();
+}
+
+bool MonteCarloPlayer::placeShips(Board& b)
+{
+    PROFILE_SCOPE("montecarlo.placeShips");
+    // Any layout is as good as another, so take a uniformly random one
+    PlacementSolver::Scratch scratch;
+    PlacementSolver solver(game(), &scratch);
+    Layout layout(&scratch);
+    if (solver.solve(game().rng(), layout) != PlacementSolver::PLACED)
+        return false;
+    return PlacementSolver::apply(layout, b);
+}
+
+namespace
+{
+    // Working space for sampling.  Chunks run on pool threads, which must
+    // not touch the game's memory, so each thread keeps its own and reuses
+    // it for every chunk it samples.
+    struct SampleScratch
+    {
+        LayoutSampler::Scratch layout;
+        vector<int> counted;                // unknown ship cells of every accepted layout
+    };
+}
+
+void MonteCarloPlayer::sampleChunk(uint64_t seed, int nSamples)
+{
+    static thread_local SampleScratch scratch;
+    Rng rng(seed);
+    vector<int>& counted = scratch.counted;
+    counted.clear();
+
+    for (int s = 0; s < nSamples; s++)
+        m_sampler.sample(rng, scratch.layout, counted);
+
+    // Merge runs of the same cell with one atomic add each
+    sort(counted.begin(), counted.end());
+    for (size_t i = 0; i < counted.size(); )
+    {
+        size_t j = i;
+        while (j < counted.size() && counted[j] == counted[i])
+            j++;
+        m_counts[counted[i]].fetch_add(static_cast<int>(j - i), memory_order_relaxed);
+        i = j;
+    }
+}
+
+Point MonteCarloPlayer::recommendAttack()
+{
+    PROFILE_SCOPE("montecarlo.recommendAttack");
+    // Early in the game the opening book may already have the answer
+    int cell = bookShot(m_sampler.stateHash());
+    if (cell >= 0 && m_unknown.contains(cell))
+        return Point(cell / game().cols(), cell % game().cols());
+
+    int nCells = game().rows() * game().cols();
+    for (int i = 0; i < nCells; i++)
+        m_counts[i].store(0, memory_order_relaxed);
+
+    // Seeds are drawn here, in order, so the result doesn't depend on scheduling
+    int nChunks = max(1, min(MAX_CHUNKS, m_samples / 16));
+    uint64_t seeds[MAX_CHUNKS];
+    game().rng().fill(seeds, nChunks);
+
+    // The task captures a single reference so it fits inside std::function
+    // without a heap allocation
+    struct Work
+    {
+        MonteCarloPlayer* player;
+        const uint64_t* seeds;
+        int nChunks;
+    } work = { this, seeds, nChunks };
+    ThreadPool::shared().parallelFor(nChunks, [&work](int chunk) {
+        int samples = work.player->m_samples;
+        int share = samples / work.nChunks + (chunk < samples % work.nChunks ? 1 : 0);
+        work.player->sampleChunk(work.seeds[chunk], share);
+    }, m_threads);
+
+    // Fire at the unknown cell occupied most often, the lowest-numbered one on a tie
+    int best = -1;
+    int bestCount = 0;
+    for (CellSet::const_iterator it = m_unknown.begin(); it != m_unknown.end(); ++it)
+    {
+        int count = m_counts[*it].load(memory_order_relaxed);
+        if (count > bestCount || (count == bestCount && count > 0 && *it < best))
+        {
+            best = *it;
+            bestCount = count;
+        }
+    }
+
+    // No layout was accepted: fall back to a random unknown cell
+    if (best < 0 && !m_unknown.empty())
+        best = m_unknown.random(game().rng());
+    if (best < 0)
+        return Point(0, 0);
+    return Point(best / game().cols(), best % game().cols());
+}
+
+void MonteCarloPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+    bool shipDestroyed, int shipId)
+{
+    PROFILE_SCOPE("montecarlo.recordAttackResult");
+    if (!validShot)
+        return;
+
+    int i = p.r * game().cols() + p.c;
+    if (!m_unknown.erase(i))
+        return;
+
+    if (!shotHit)
+    {
+        m_sampler.recordMiss(i);
+        return;
+    }
+
+    m_sampler.recordHit(i);
+    if (shipDestroyed && shipId >= 0 && shipId < game().nShips())
+        m_sampler.recordSunk(shipId, i);
+}
+
+void MonteCarloPlayer::recordAttackByOpponent(Point /* p */)
+{
+    // MonteCarloPlayer ignores what the opponent does
+}
+
+void MonteCarloPlayer::reset()
+{
+    m_sampler.reset();
+    m_unknown.fill();
+}
+
+//*********************************************************************
+//  MctsPlayer
+//*********************************************************************
+
+// Monte Carlo tree search over shot choices.  Each iteration draws one
+// layout that agrees with everything seen so far (a determinization),
+// walks down the tree picking shots and following the outcome each shot
+// has in that layout (miss, hit, or which ship sank), adds one
+// node, and finishes the game with a fast hunt-and-target rollout.  An
+// action's value is the mean number of shots the games through it needed
+// to sink the whole fleet, so the tree averages over the hidden layouts
+// the way expectimax averages over chance nodes.  Shots are picked as in
+// PUCT: each is tried in proportion to how often the sampled layouts put a
+// ship there until the rollouts show it to be better or worse than that.
+//
+// The shots tried at the root are the cells most often occupied in a batch
+// of layouts drawn when the move starts.  Deeper down they are the unknown
+// neighbours of hits on ships still afloat in the drawn layout, or if there
+// are none, the likeliest cells from that same batch.
+//
+// Several independent trees grow at once on the shared thread pool and
+// their root visit counts are summed.  A move stops after its iteration
+// budget or its time budget, whichever comes first.  Without a time budget
+// the chosen shot depends only on the game's seed.
+class MctsPlayer : public Player
+{
+public:
+    MctsPlayer(string nm, const Game& g, int iterations, int budgetMs, int threads);
+    ~MctsPlayer() {}
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+        bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+private:
+    struct SearchScratch;
+
+    // Rank the unknown cells by how often sampled layouts occupy them
+    void rankCells();
+    // Shots worth trying now: the cells most often occupied
+    void rootCandidates(vector<int>& out) const;
+    // Grow one tree with its own generator, starting from the shots in
+    // root, until out of iterations or time.  Stores how often each root
+    // shot was visited in visits.
+    void searchTree(uint64_t seed, int iterations, chrono::steady_clock::time_point deadline,
+        const vector<int>& root, int* visits) const;
+
+    // Shots worth trying in the current state of a search, best first
+    void candidates(const SearchScratch& s, vector<int>& out) const;
+    // Shot a rollout takes next
+    int rolloutShot(SearchScratch& s, Rng& rng) const;
+
+    static constexpr int MAX_TREES = 32;
+    static constexpr int HUNT_CANDIDATES = 8;       // shots tried at a node with no open hits
+    static constexpr int RANK_SAMPLES = 256;        // layouts drawn to rank the cells each move
+
+    int m_iterations;                       // per move, 0 for as many as the time allows
+    int m_budgetMs;                         // per move, 0 for no time limit
+    int m_threads;                          // threads searching, 0 for the whole pool
+    LayoutSampler m_sampler;                // everything seen of the opponent's board
+    CellSet m_unknown;                      // cells not yet attacked
+    pmr::vector<int> m_counts;              // sampled layouts occupying each cell
+    pmr::vector<int> m_ranked;              // unknown cells, most often occupied first
+    pmr::vector<int> m_hits;                // cells that were hits
+    pmr::vector<int> m_visits;              // root visit counts of every tree, tree by tree
+};
+
+// One search in progress: the layout drawn for the iteration, what has been
+// shot in it, and the tree itself.  Each pool thread keeps one and reuses it.
+struct MctsPlayer::SearchScratch
+{
+    struct Node
+    {
+        int firstAction;
+        int nActions;
+        int visits;
+        double shots;                       // total shots of the games through this node
+    };
+    struct Action
+    {
+        int cell;
+        int visits;
+        double shots;                       // total shots of the games through this action
+        double prior;                       // share of the node's sampled ship cells
+        int firstOutcome;                   // list of the nodes it led to, by outcome
+    };
+    struct Outcome
+    {
+        int key;                            // 0 miss, 1 hit, 2 + shipId sunk
+        int node;
+        int next;
+    };
+
+    LayoutSampler::Scratch layout;
+    vector<int> layoutCells;                // unknown cells of the layout
+    vector<int> cellShip;                   // ship at each cell in the layout, or -1
+    vector<int> remaining;                  // unshot cells of each ship in the layout
+    vector<int> shipCells;                  // cells given a ship in cellShip
+    vector<char> shot;                      // cells shot so far, in the game or the search
+    vector<int> searchShots;                // cells shot by the search this iteration
+    vector<int> openHits;                   // hits on ships still afloat
+    int shipsAfloat;
+    int huntPos;                            // no unshot cell in m_ranked before this
+
+    vector<Node> nodes;
+    vector<Action> actions;
+    vector<Outcome> outcomes;
+    vector<int> path;                       // actions taken this iteration
+    vector<int> choices;
+
+    // Shoot cell in the drawn layout and return the outcome key
+    int fire(int cell)
+    {
+        shot[cell] = 1;
+        searchShots.push_back(cell);
+        int shipId = cellShip[cell];
+        if (shipId < 0)
+            return 0;
+        if (--remaining[shipId] > 0)
+        {
+            openHits.push_back(cell);
+            return 1;
+        }
+        // The ship's hits are no longer open
+        --shipsAfloat;
+        size_t kept = 0;
+        for (size_t h = 0; h < openHits.size(); h++)
+            if (cellShip[openHits[h]] != shipId)
+                openHits[kept++] = openHits[h];
+        openHits.resize(kept);
+        return 2 + shipId;
+    }
+};
+
+MctsPlayer::MctsPlayer(string nm, const Game& g, int iterations, int budgetMs, int threads)
+    : Player(nm, g), m_iterations(iterations), m_budgetMs(budgetMs), m_threads(threads),
+      m_sampler(g), m_unknown(g.rows() * g.cols(), g.memory()), m_counts(g.rows() * g.cols(), 0, g.memory()),
+      m_ranked(g.memory()), m_hits(g.memory()), m_visits(g.memory())
+{
+    m_unknown.fill();
+    m_ranked.reserve(g.rows() * g.cols());
+}
+
+bool MctsPlayer::placeShips(Board& b)
+{
+    PROFILE_SCOPE("mcts.placeShips");
+    // Any layout is as good as another, so take a uniformly random one
+    PlacementSolver::Scratch scratch;
+    PlacementSolver solver(game(), &scratch);
+    Layout layout(&scratch);
+    if (solver.solve(game().rng(), layout) != PlacementSolver::PLACED)
+        return false;
+    return PlacementSolver::apply(layout, b);
+}
+
+void MctsPlayer::rankCells()
+{
+    static thread_local LayoutSampler::Scratch scratch;
+    static thread_local vector<int> cells;
+    fill(m_counts.begin(), m_counts.end(), 0);
+    Rng rng(game().rng().next());
+    for (int s = 0; s < RANK_SAMPLES; s++)
+    {
+        cells.clear();
+        if (m_sampler.sample(rng, scratch, cells))
+            for (size_t k = 0; k < cells.size(); k++)
+                m_counts[cells[k]]++;
+    }
+
+    m_ranked.assign(m_unknown.begin(), m_unknown.end());
+    sort(m_ranked.begin(), m_ranked.end(), [this](int a, int b) {
+        return m_counts[a] != m_counts[b] ? m_counts[a] > m_counts[b] : a < b;
+    });
+}
+
+void MctsPlayer::rootCandidates(vector<int>& out) const
+{
+    // Next to a ship that has been hit, the likeliest cells are its
+    // neighbours anyway
+    out.clear();
+    for (size_t k = 0; k < m_ranked.size() && k < HUNT_CANDIDATES; k++)
+        out.push_back(m_ranked[k]);
+}
+
+void MctsPlayer::candidates(const SearchScratch& s, vector<int>& out) const
+{
+    out.clear();
+    int rows = game().rows();
+    int cols = game().cols();
+
+    // Finish off a ship that has been hit
+    for (size_t h = 0; h < s.openHits.size(); h++)
+    {
+        int r = s.openHits[h] / cols;
+        int c = s.openHits[h] % cols;
+        int next[4] = { r > 0 ? s.openHits[h] - cols : -1, r < rows - 1 ? s.openHits[h] + cols : -1,
+                        c > 0 ? s.openHits[h] - 1 : -1, c < cols - 1 ? s.openHits[h] + 1 : -1 };
+        for (int d = 0; d < 4; d++)
+            if (next[d] >= 0 && !s.shot[next[d]] && find(out.begin(), out.end(), next[d]) == out.end())
+                out.push_back(next[d]);
+    }
+    if (!out.empty())
+        return;
+
+    // Otherwise hunt where ships are most likely
+    for (size_t k = s.huntPos; k < m_ranked.size() && out.size() < HUNT_CANDIDATES; k++)
+        if (!s.shot[m_ranked[k]])
+            out.push_back(m_ranked[k]);
+}
+
+int MctsPlayer::rolloutShot(SearchScratch& s, Rng& rng) const
+{
+    int rows = game().rows();
+    int cols = game().cols();
+
+    // Target: a neighbour of an open hit, preferring one that extends a
+    // line of two hits
+    int best = -1;
+    int bestScore = 0;
+    int nBest = 0;
+    for (size_t h = 0; h < s.openHits.size(); h++)
+    {
+        int cell = s.openHits[h];
+        int r = cell / cols;
+        int c = cell % cols;
+        const int dr[4] = { -1, 1, 0, 0 };
+        const int dc[4] = { 0, 0, -1, 1 };
+        for (int d = 0; d < 4; d++)
+        {
+            int nr = r + dr[d];
+            int nc = c + dc[d];
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols || s.shot[nr * cols + nc])
+                continue;
+            int br = r - dr[d];
+            int bc = c - dc[d];
+            bool inLine = (br >= 0 && br < rows && bc >= 0 && bc < cols &&
+                s.cellShip[br * cols + bc] >= 0 && s.shot[br * cols + bc] &&
+                s.remaining[s.cellShip[br * cols + bc]] > 0);
+            int score = (inLine ? 2 : 1);
+            if (score > bestScore)
+            {
+                best = nr * cols + nc;
+                bestScore = score;
+                nBest = 1;
+            }
+            else if (score == bestScore && rng.nextInt(++nBest) == 0)
+                best = nr * cols + nc;
+        }
+    }
+    if (best >= 0)
+        return best;
+
+    // Hunt: the likeliest cell left
+    while (s.shot[m_ranked[s.huntPos]])
+        s.huntPos++;
+    return m_ranked[s.huntPos];
+}
+
+void MctsPlayer::searchTree(uint64_t seed, int iterations, chrono::steady_clock::time_point deadline,
+    const vector<int>& root, int* visits) const
+{
+    typedef SearchScratch::Node Node;
+    typedef SearchScratch::Action Action;
+    typedef SearchScratch::Outcome Outcome;
+
+    // Weight of the sampled hit chances against the rollouts, in shots.
+    // Rollouts are noisy, so the chances win unless the evidence is strong.
+    const double EXPLORE = 300.0;
+
+    static thread_local SearchScratch scratch;
+    SearchScratch& s = scratch;
+    Rng rng(seed);
+    const PlacementTable& table = m_sampler.table();
+    int nCells = game().rows() * game().cols();
+    int nShips = game().nShips();
+    bool timed = (m_budgetMs > 0);
+
+    s.cellShip.assign(nCells, -1);
+    s.shot.assign(nCells, 0);
+    for (int i = 0; i < nCells; i++)
+        s.shot[i] = (m_sampler.state(i) != LayoutSampler::UNKNOWN);
+    s.remaining.resize(nShips);
+    s.shipCells.clear();
+    s.searchShots.clear();
+    s.nodes.clear();
+    s.actions.clear();
+    s.outcomes.clear();
+
+    // Add a node trying choices, returning its number
+    auto expand = [this, &s](const vector<int>& choices) {
+        Node n;
+        n.firstAction = static_cast<int>(s.actions.size());
+        n.nActions = static_cast<int>(choices.size());
+        n.visits = 0;
+        n.shots = 0;
+        double total = 0;
+        for (size_t k = 0; k < choices.size(); k++)
+            total += m_counts[choices[k]] + 1;
+        for (size_t k = 0; k < choices.size(); k++)
+            s.actions.push_back(Action{ choices[k], 0, 0.0, (m_counts[choices[k]] + 1) / total, -1 });
+        s.nodes.push_back(n);
+        return static_cast<int>(s.nodes.size()) - 1;
+    };
+    expand(root);
+
+    for (int it = 0; it < iterations; it++)
+    {
+        if (timed && it % 8 == 0 && chrono::steady_clock::now() >= deadline)
+            break;
+
+        // Determinize
+        s.layoutCells.clear();
+        if (!m_sampler.sample(rng, s.layout, s.layoutCells))
+            continue;
+        for (size_t k = 0; k < s.shipCells.size(); k++)
+            s.cellShip[s.shipCells[k]] = -1;
+        s.shipCells.clear();
+        s.shipsAfloat = 0;
+        for (int shipId = 0; shipId < nShips; shipId++)
+        {
+            s.remaining[shipId] = 0;
+            for (int j = 0, i = s.layout.start[shipId]; j < table.shipLength(shipId); j++, i += s.layout.stride[shipId])
+            {
+                s.cellShip[i] = shipId;
+                s.shipCells.push_back(i);
+                if (!s.shot[i])
+                    s.remaining[shipId]++;
+            }
+            if (s.remaining[shipId] > 0)
+                s.shipsAfloat++;
+        }
+        s.openHits.clear();
+        for (size_t h = 0; h < m_hits.size(); h++)
+            if (s.remaining[s.cellShip[m_hits[h]]] > 0)
+                s.openHits.push_back(m_hits[h]);
+        s.huntPos = 0;
+
+        // Select and expand
+        s.path.clear();
+        int node = 0;
+        int shots = 0;
+        while (s.shipsAfloat > 0 && s.nodes[node].nActions > 0)
+        {
+            // The likelier a shot is to hit, the more it is tried before the
+            // rollouts have had their say.  Untried shots are scored as the
+            // node's average.
+            const Node& n = s.nodes[node];
+            int chosen = -1;
+            double bestValue = 0;
+            double unvisited = (n.visits > 0 ? -n.shots / n.visits : 0.0);
+            double sqrtVisits = sqrt(max(1, n.visits));
+            for (int a = n.firstAction; a < n.firstAction + n.nActions; a++)
+            {
+                const Action& act = s.actions[a];
+                double value = (act.visits > 0 ? -act.shots / act.visits : unvisited) +
+                    EXPLORE * act.prior * sqrtVisits / (1 + act.visits);
+                if (chosen < 0 || value > bestValue)
+                {
+                    chosen = a;
+                    bestValue = value;
+                }
+            }
+            s.path.push_back(node);
+            s.path.push_back(chosen);
+            int key = s.fire(s.actions[chosen].cell);
+            shots++;
+            if (s.shipsAfloat == 0)
+                break;
+
+            int o = s.actions[chosen].firstOutcome;
+            while (o >= 0 && s.outcomes[o].key != key)
+                o = s.outcomes[o].next;
+            if (o >= 0)
+            {
+                node = s.outcomes[o].node;
+                continue;
+            }
+            candidates(s, s.choices);
+            int child = expand(s.choices);
+            s.outcomes.push_back(Outcome{ key, child, s.actions[chosen].firstOutcome });
+            s.actions[chosen].firstOutcome = static_cast<int>(s.outcomes.size()) - 1;
+            break;
+        }
+
+        // Play the game out
+        while (s.shipsAfloat > 0)
+        {
+            s.fire(rolloutShot(s, rng));
+            shots++;
+        }
+
+        for (size_t k = 0; k < s.path.size(); k += 2)
+        {
+            s.nodes[s.path[k]].visits++;
+            s.nodes[s.path[k]].shots += shots;
+            s.actions[s.path[k + 1]].visits++;
+            s.actions[s.path[k + 1]].shots += shots;
+        }
+        for (size_t k = 0; k < s.searchShots.size(); k++)
+            s.shot[s.searchShots[k]] = 0;
+        s.searchShots.clear();
+    }
+
+    for (size_t a = 0; a < root.size(); a++)
+        visits[a] = s.actions[a].visits;
+}
+
+Point MctsPlayer::recommendAttack()
+{
+    PROFILE_SCOPE("mcts.recommendAttack");
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(m_budgetMs);
+    int cols = game().cols();
+    if (m_unknown.empty())
+        return Point(0, 0);
+
+    // Early in the game the opening book may already have the answer
+    int cell = bookShot(m_sampler.stateHash());
+    if (cell >= 0 && m_unknown.contains(cell))
+        return Point(cell / cols, cell % cols);
+
+    rankCells();
+    vector<int> rootCells;
+    rootCandidates(rootCells);
+    if (rootCells.size() == 1)
+        return Point(rootCells[0] / cols, rootCells[0] % cols);
+
+    // Trees are handed to pool threads one at a time, so threads that finish
+    // early take on the ones left.  Seeds are drawn here, in order.
+    int nTrees;
+    if (m_iterations > 0)
+        nTrees = max(1, min(MAX_TREES, m_iterations / 256));
+    else
+        nTrees = min(MAX_TREES, m_threads > 0 ? m_threads : ThreadPool::shared().size() + 1);
+    uint64_t seeds[MAX_TREES];
+    game().rng().fill(seeds, nTrees);
+    int nRoot = static_cast<int>(rootCells.size());
+    m_visits.assign(nTrees * nRoot, 0);
+
+    // The task captures a single reference so it fits inside std::function
+    // without a heap allocation
+    struct Work
+    {
+        MctsPlayer* player;
+        const uint64_t* seeds;
+        const vector<int>* root;
+        int nTrees;
+        chrono::steady_clock::time_point deadline;
+    } work = { this, seeds, &rootCells, nTrees, deadline };
+    ThreadPool::shared().parallelFor(nTrees, [&work](int tree) {
+        MctsPlayer* p = work.player;
+        int iterations = INT_MAX;
+        if (p->m_iterations > 0)
+            iterations = p->m_iterations / work.nTrees + (tree < p->m_iterations % work.nTrees ? 1 : 0);
+        int nRoot = static_cast<int>(work.root->size());
+        p->searchTree(work.seeds[tree], iterations, work.deadline, *work.root, &p->m_visits[tree * nRoot]);
+    }, m_threads);
+
+    // The most visited shot, the one ranked higher on a tie
+    int best = 0;
+    long bestVisits = -1;
+    for (int a = 0; a < nRoot; a++)
+    {
+        long total = 0;
+        for (int t = 0; t < nTrees; t++)
+            total += m_visits[t * nRoot + a];
+        if (total > bestVisits)
+        {
+            best = a;
+            bestVisits = total;
+        }
+    }
+    return Point(rootCells[best] / cols, rootCells[best] % cols);
+}
+
+void MctsPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+    bool shipDestroyed, int shipId)
+{
+    PROFILE_SCOPE("mcts.recordAttackResult");
+    if (!validShot)
+        return;
+
+    int i = p.r * game().cols() + p.c;
+    if (!m_unknown.erase(i))
+        return;
+
+    if (!shotHit)
+    {
+        m_sampler.recordMiss(i);
+        return;
+    }
+
+    m_sampler.recordHit(i);
+    m_hits.push_back(i);
+    if (shipDestroyed && shipId >= 0 && shipId < game().nShips())
+        m_sampler.recordSunk(shipId, i);
+}
+
+void MctsPlayer::recordAttackByOpponent(Point /* p */)
+{
+    // MctsPlayer ignores what the opponent does
+}
+
+void MctsPlayer::reset()
+{
+    m_sampler.reset();
+    m_unknown.fill();
+    m_hits.clear();
+}
+
+//*********************************************************************
+//  HeatPlayer
+//*********************************************************************
+
+// Fires every shot at the unknown cell covered by the most placements of
+// the fleet that cross no miss.  Placements through a hit count first, so
+// it finishes off ships it has found; the rest break ties, then the lowest
+// cell.  It ignores which ships have sunk.  Its shots depend only on what
+// it has seen, so LockstepEngine can run the same rule for many games at
+// once.
+class HeatPlayer : public Player
+{
+public:
+    HeatPlayer(string nm, const Game& g);
+    ~HeatPlayer() {}
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+        bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+private:
+    enum { UNKNOWN, MISS, HIT };
+    typedef PlacementTable::SmallMask Mask;
+
+    // Fill m_weight and m_hitWeight from m_known for any fleet
+    void countPlacements();
+    // The same for a FixedFleet the game matches, one ship at a time with
+    // its length, placement count and masks as constants
+    template <class Fleet, int... ShipIds>
+    void countPlacements(integer_sequence<int, ShipIds...>);
+    template <class Fleet, int ShipId>
+    void countShip();
+
+    bool m_small;                                   // board fits in a Mask
+    Grid<char> m_known;                             // UNKNOWN, MISS or HIT for each cell
+    Mask m_misses, m_hits;                          // m_known as masks, if m_small
+    Grid<int> m_hitWeight;                          // placements through the cell and a hit
+    Grid<int> m_weight;                             // placements through the cell
+};
+
+HeatPlayer::HeatPlayer(string nm, const Game& g)
+    : Player(nm, g), m_small(g.rows() * g.cols() <= SMALL_BOARD_CELLS),
+      m_known(g.rows(), g.cols(), g.memory()),
+      m_hitWeight(g.rows(), g.cols(), g.memory()), m_weight(g.rows(), g.cols(), g.memory())
+{
+    m_known.fill(UNKNOWN);
+}
+
+bool HeatPlayer::placeShips(Board& b)
+{
+    PROFILE_SCOPE("heat.placeShips");
+    // Every layout of the fleet is as likely as any other
+    PlacementSolver::Scratch scratch;
+    PlacementSolver solver(game(), &scratch);
+    Layout layout(&scratch);
+    return solver.solve(game().rng(), layout) == PlacementSolver::PLACED &&
+        PlacementSolver::apply(layout, b);
+}
+
+Point HeatPlayer::recommendAttack()
+{
+    PROFILE_SCOPE("heat.recommendAttack");
+    int rows = game().rows();
+    int cols = game().cols();
+    m_hitWeight.fill(0);
+    m_weight.fill(0);
+
+    if (m_small && StandardFleet::matches(game().placementTable()))
+        countPlacements<StandardFleet>(make_integer_sequence<int, StandardFleet::N_SHIPS>());
+    else
+        countPlacements();
+
+    int best = 0;
+    bool found = false;
+    for (int cell = 0; cell < rows * cols; cell++)
+    {
+        if (m_known[cell] != UNKNOWN)
+            continue;
+        if (!found || m_hitWeight[cell] > m_hitWeight[best] ||
+            (m_hitWeight[cell] == m_hitWeight[best] && m_weight[cell] > m_weight[best]))
+            best = cell;
+        found = true;
+    }
+    return Point(best / cols, best % cols);
+}
+
+void HeatPlayer::countPlacements()
+{
+    int rows = game().rows();
+    int cols = game().cols();
+    for (int k = 0; k < game().nShips(); k++)
+    {
+        int len = game().shipLength(k);
+        for (int vertical = 0; vertical < 2; vertical++)
+        {
+            int step = (vertical ? cols : 1);
+            for (int r = 0; r + (vertical ? len : 1) <= rows; r++)
+                for (int c = 0; c + (vertical ? 1 : len) <= cols; c++)
+                {
+                    int start = r * cols + c;
+                    bool clear = true, throughHit = false;
+                    for (int i = 0; i < len && clear; i++)
+                    {
+                        clear = (m_known[start + i * step] != MISS);
+                        throughHit |= (m_known[start + i * step] == HIT);
+                    }
+                    if (!clear)
+                        continue;
+                    for (int i = 0; i < len; i++)
+                    {
+                        m_weight[start + i * step]++;
+                        if (throughHit)
+                            m_hitWeight[start + i * step]++;
+                    }
+                }
+        }
+    }
+}
+
+template <class Fleet, int... ShipIds>
+void HeatPlayer::countPlacements(integer_sequence<int, ShipIds...>)
+{
+    (countShip<Fleet, ShipIds>(), ...);
+}
+
+template <class Fleet, int ShipId>
+void HeatPlayer::countShip()
+{
+    // Ships of the same length share their placements, so the first of
+    // them counts for all
+    constexpr int LEN = Fleet::LENGTHS[ShipId];
+    if constexpr (Fleet::firstOfLength(ShipId))
+    {
+        constexpr int N_HORIZONTAL = Fleet::nHorizontal(LEN);
+        constexpr int N_SEGMENTS = Fleet::nSegments(LEN);
+        constexpr int COUNT = Fleet::multiplicity(LEN);
+        const FleetMasks<Fleet>& masks = Fleet::masks();
+        int* weight = &m_weight[0];
+        int* hitWeight = &m_hitWeight[0];
+
+        // Masks decide whether a placement counts; its cells are then a
+        // loop of LEN steps of a constant stride
+        auto add = [&](int k, int step) {
+            const Mask& cells = masks.mask(ShipId, k);
+            if (cells.intersects(m_misses))
+                return;
+            int throughHit = COUNT * cells.intersects(m_hits);
+            for (int i = 0, cell = Fleet::start(LEN, k); i < LEN; i++, cell += step)
+            {
+                weight[cell] += COUNT;
+                hitWeight[cell] += throughHit;
+            }
+        };
+        for (int k = 0; k < N_HORIZONTAL; k++)
+            add(k, 1);
+        for (int k = N_HORIZONTAL; k < N_SEGMENTS; k++)
+            add(k, Fleet::COLS);
+    }
+}
+
+void HeatPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+    bool /* shipDestroyed */, int /* shipId */)
+{
+    PROFILE_SCOPE("heat.recordAttackResult");
+    if (!validShot)
+        return;
+    m_known(p.r, p.c) = (shotHit ? HIT : MISS);
+    if (m_small)
+        (shotHit ? m_hits : m_misses).set(p.r * game().cols() + p.c);
+}
+
+void HeatPlayer::recordAttackByOpponent(Point /* p */)
+{
+    // HeatPlayer only watches its own shots
+}
+
+void HeatPlayer::reset()
+{
+    m_known.fill(UNKNOWN);
+    m_misses.clear();
+    m_hits.clear();
+}
+
+//*********************************************************************
+//  SplitPlayer
+//*********************************************************************
+
+// Places ships like one player and attacks like another, so the two halves
+// of a strategy can be judged separately.  Owns both.
+class SplitPlayer : public Player
+{
+public:
+    SplitPlayer(string nm, const Game& g, Player* placer, Player* attacker)
+        : Player(nm, g), m_placer(placer), m_attacker(attacker)
+    {}
+    ~SplitPlayer()
     {
-    case 0:  return new HumanPlayer(nm, g);
-    case 1:  return new AwfulPlayer(nm, g);
-    case 2:  return new MediocrePlayer(nm, g);
-    case 3:  return new GoodPlayer(nm, g);
+        delete m_placer;
+        delete m_attacker;
+    }
+    virtual bool placeShips(Board& b) { return m_placer->placeShips(b); }
+    virtual Point recommendAttack() { return m_attacker->recommendAttack(); }
+    virtual bool tryAttack(Point& p, const function<void()>& ready) { return m_attacker->tryAttack(p, ready); }
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+        bool shipDestroyed, int shipId)
+    {
+        m_attacker->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+    }
+    virtual void recordAttackByOpponent(Point p) { m_attacker->recordAttackByOpponent(p); }
+    virtual void reset()
+    {
+        m_placer->reset();
+        m_attacker->reset();
+    }
+private:
+    Player* m_placer;
+    Player* m_attacker;
+};
+
+//*********************************************************************
+//  createPlayer
+//*********************************************************************
+
+static const string PLAYER_TYPES[] = {
+    "human", "awful", "mediocre", "good", "montecarlo", "mcts", "heat"
+};
+
+vector<string> aiPlayerTypes()
+{
+    // Every type but the first, "human"
+    return vector<string>(PLAYER_TYPES + 1, PLAYER_TYPES + sizeof(PLAYER_TYPES) / sizeof(PLAYER_TYPES[0]));
+}
+
+Player* createPlayer(string type, string nm, const Game& g)
+{
+    // "placement/targeting" combines two computer players
+    size_t slash = type.find('/');
+    if (slash != string::npos)
+    {
+        Player* placer = createPlayer(type.substr(0, slash), nm, g);
+        Player* attacker = createPlayer(type.substr(slash + 1), nm, g);
+        if (placer == nullptr || attacker == nullptr || placer->isHuman() || attacker->isHuman())
+        {
+            delete placer;
+            delete attacker;
+            return nullptr;
+        }
+        return new (g.memory()) SplitPlayer(nm, g, placer, attacker);
+    }
+
+    // Options follow the type name, separated by colons, e.g. "montecarlo:5000:4"
+    vector<int> options;
+    size_t colon = type.find(':');
+    if (colon != string::npos)
+    {
+        for (size_t pos = colon; pos != string::npos; pos = type.find(':', pos + 1))
+            options.push_back(atoi(type.c_str() + pos + 1));
+        type.erase(colon);
+    }
+
+    int pos;
+    for (pos = 0; pos != sizeof(PLAYER_TYPES) / sizeof(PLAYER_TYPES[0]) && type != PLAYER_TYPES[pos]; pos++)
+        ;
+    switch (pos)
+    {
+    case 0:  return new (g.memory()) HumanPlayer(nm, g);
+    case 1:  return new (g.memory()) AwfulPlayer(nm, g);
+    case 2:  return new (g.memory()) MediocrePlayer(nm, g);
+    case 3:  return new (g.memory()) GoodPlayer(nm, g);
+    case 4:  // montecarlo[:samples per shot[:threads]]
+        return new (g.memory()) MonteCarloPlayer(nm, g,
+            options.size() > 0 && options[0] > 0 ? options[0] : 1000,
+            options.size() > 1 ? options[1] : 0);
+    case 5:  // mcts[:iterations per shot[:milliseconds per shot[:threads]]]
+    {
+        int iterations = options.size() > 0 ? max(0, options[0]) : 2000;
+        int budgetMs = options.size() > 1 ? max(0, options[1]) : 0;
+        if (iterations == 0 && budgetMs == 0)
+            iterations = 2000;
+        return new (g.memory()) MctsPlayer(nm, g, iterations, budgetMs,
+            options.size() > 2 ? options[2] : 0);
+    }
+    case 6:  return new (g.memory()) HeatPlayer(nm, g);
     default: return nullptr;
     }
 }
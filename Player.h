@@ -1,13 +1,19 @@
 #ifndef PLAYER_INCLUDED
 #define PLAYER_INCLUDED
 
+#include "Arena.h"
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
 
 class Point;
 class Board;
 class Game;
 
-class Player
+// createPlayer allocates players from the game's memory resource; delete
+// works on them regardless.
+class Player : public ResourceAllocated
 {
 public:
     Player(std::string nm, const Game& g)
@@ -23,18 +29,42 @@ public:
 
     virtual bool placeShips(Board& b) = 0;
     virtual Point recommendAttack() = 0;
+    // recommendAttack for games that must not block (see GameTask).  Set p
+    // and return true if a shot is ready now.  Otherwise return false and
+    // call ready, from any thread, once asking again will find one.  The
+    // default answers at once with recommendAttack.
+    virtual bool tryAttack(Point& p, const std::function<void()>& ready);
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
         bool shipDestroyed, int shipId) = 0;
     virtual void recordAttackByOpponent(Point p) = 0;
+    // Forget the game in progress and start over as if newly created,
+    // reusing the memory the player already has
+    virtual void reset() = 0;
     // We prevent any kind of Player object from being copied or assigned
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
 
+protected:
+    // The cell the game's opening book gives for the observed state with
+    // Zobrist hash stateHash, or -1 if there is no book or it has no entry
+    int bookShot(uint64_t stateHash) const;
+
 private:
     std::string m_name;
     const Game& m_game;
 };
 
+// type is one of "human", "awful", "mediocre", "good", "montecarlo", "mcts"
+// or "heat".  "montecarlo:<samples>:<threads>" sets the layouts sampled per
+// shot (default 1000) and the threads sampling them (default all cores).
+// "mcts:<iterations>:<ms>:<threads>" sets the search iterations per shot
+// (default 2000), a time limit per shot (default none) and the threads
+// searching (default all cores).  "<placement>/<targeting>", e.g.
+// "good/montecarlo:5000", places ships like the first computer player and
+// attacks like the second.
 Player* createPlayer(std::string type, std::string nm, const Game& g);
 
+// Every computer player type createPlayer knows, without options
+std::vector<std::string> aiPlayerTypes();
+
 #endif // PLAYER_INCLUDED
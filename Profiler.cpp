@@ -0,0 +1,240 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+atomic<bool> Profiler::s_enabled(false);
+
+namespace
+{
+    // Values below EXACT get a bucket each; above, every power of two is
+    // split into SUB_BUCKETS buckets
+    const int SUB_BITS = 3;
+    const int SUB_BUCKETS = 1 << SUB_BITS;
+    const int EXACT = 2 * SUB_BUCKETS;
+    const int N_BUCKETS = EXACT + (64 - SUB_BITS - 1) * SUB_BUCKETS;
+
+    int bucketOf(uint64_t v)
+    {
+        if (v < static_cast<uint64_t>(EXACT))
+            return static_cast<int>(v);
+        int e = 63 - __builtin_clzll(v);                    // 2^e <= v < 2^(e+1), e >= SUB_BITS + 1
+        int sub = static_cast<int>(v >> (e - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return EXACT + (e - SUB_BITS - 1) * SUB_BUCKETS + sub;
+    }
+
+    // Largest value that falls in bucket b
+    uint64_t bucketTop(int b)
+    {
+        if (b < EXACT)
+            return b;
+        int e = (b - EXACT) / SUB_BUCKETS + SUB_BITS + 1;
+        uint64_t sub = (b - EXACT) % SUB_BUCKETS;
+        uint64_t low = (uint64_t(1) << e) + (sub << (e - SUB_BITS));
+        return low + (uint64_t(1) << (e - SUB_BITS)) - 1;
+    }
+
+    // One thread's calls of one probe.  Only the owning thread writes, so
+    // updates are plain loads and stores; they are atomic only so that
+    // writeJson may read them while the owner records.
+    struct Histogram
+    {
+        atomic<uint64_t> count{ 0 };
+        atomic<uint64_t> sum{ 0 };
+        atomic<uint64_t> max{ 0 };
+        atomic<uint64_t> buckets[N_BUCKETS] = {};
+
+        void add(uint64_t v)
+        {
+            bump(count, 1);
+            bump(sum, v);
+            if (v > max.load(memory_order_relaxed))
+                max.store(v, memory_order_relaxed);
+            bump(buckets[bucketOf(v)], 1);
+        }
+
+        void clear()
+        {
+            count.store(0, memory_order_relaxed);
+            sum.store(0, memory_order_relaxed);
+            max.store(0, memory_order_relaxed);
+            for (int b = 0; b < N_BUCKETS; b++)
+                buckets[b].store(0, memory_order_relaxed);
+        }
+
+        static void bump(atomic<uint64_t>& a, uint64_t n)
+        {
+            a.store(a.load(memory_order_relaxed) + n, memory_order_relaxed);
+        }
+    };
+
+    // The histograms of one thread, created as its probes are first used
+    struct ThreadHistograms
+    {
+        atomic<Histogram*> probes[Profiler::MAX_PROBES] = {};
+
+        ~ThreadHistograms()
+        {
+            for (int p = 0; p < Profiler::MAX_PROBES; p++)
+                delete probes[p].load();
+        }
+    };
+
+    struct Registry
+    {
+        mutex lock;
+        const char* names[Profiler::MAX_PROBES];
+        atomic<int> nProbes{ 0 };
+        // Kept after their threads exit, so their calls are still counted
+        vector<unique_ptr<ThreadHistograms> > threads;
+    };
+
+    Registry& registry()
+    {
+        static Registry r;
+        return r;
+    }
+
+    ThreadHistograms& threadHistograms()
+    {
+        static thread_local ThreadHistograms* mine = nullptr;
+        if (mine == nullptr)
+        {
+            Registry& r = registry();
+            lock_guard<mutex> lock(r.lock);
+            r.threads.emplace_back(new ThreadHistograms);
+            mine = r.threads.back().get();
+        }
+        return *mine;
+    }
+
+    // Registered names are fixed strings, but escape them anyway
+    void writeName(ostream& out, const char* s)
+    {
+        out << '"';
+        for ( ; *s != '\0'; s++)
+        {
+            if (*s == '"' || *s == '\\')
+                out << '\\';
+            out << *s;
+        }
+        out << '"';
+    }
+}
+
+int Profiler::probe(const char* name)
+{
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.lock);
+    int n = r.nProbes.load(memory_order_relaxed);
+    for (int p = 0; p < n; p++)
+        if (string(r.names[p]) == name)
+            return p;
+    if (n == MAX_PROBES)
+        return MAX_PROBES - 1;          // share the last probe rather than fail
+    r.names[n] = name;
+    r.nProbes.store(n + 1, memory_order_release);
+    return n;
+}
+
+void Profiler::record(int probe, uint64_t nanos)
+{
+    ThreadHistograms& t = threadHistograms();
+    Histogram* h = t.probes[probe].load(memory_order_relaxed);
+    if (h == nullptr)
+    {
+        h = new Histogram;
+        t.probes[probe].store(h, memory_order_release);
+    }
+    h->add(nanos);
+}
+
+void Profiler::reset()
+{
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.lock);
+    for (size_t t = 0; t < r.threads.size(); t++)
+        for (int p = 0; p < MAX_PROBES; p++)
+        {
+            Histogram* h = r.threads[t]->probes[p].load(memory_order_acquire);
+            if (h != nullptr)
+                h->clear();
+        }
+}
+
+void Profiler::writeJson(ostream& out)
+{
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.lock);
+    int nProbes = r.nProbes.load(memory_order_acquire);
+
+    const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+    const char* const QUANTILE_NAMES[] = { "p50", "p90", "p99", "p999" };
+    const int N_QUANTILES = 4;
+
+    char buf[64];
+    vector<uint64_t> buckets(N_BUCKETS);
+    out << "{\n  \"unit\": \"ns\",\n  \"probes\": [";
+    bool firstProbe = true;
+    for (int p = 0; p < nProbes; p++)
+    {
+        uint64_t count = 0, sum = 0, max = 0;
+        fill(buckets.begin(), buckets.end(), 0);
+        for (size_t t = 0; t < r.threads.size(); t++)
+        {
+            const Histogram* h = r.threads[t]->probes[p].load(memory_order_acquire);
+            if (h == nullptr)
+                continue;
+            count += h->count.load(memory_order_relaxed);
+            sum += h->sum.load(memory_order_relaxed);
+            if (h->max.load(memory_order_relaxed) > max)
+                max = h->max.load(memory_order_relaxed);
+            for (int b = 0; b < N_BUCKETS; b++)
+                buckets[b] += h->buckets[b].load(memory_order_relaxed);
+        }
+        if (count == 0)
+            continue;
+
+        out << (firstProbe ? "" : ",") << "\n    {\n      \"name\": ";
+        writeName(out, r.names[p]);
+        out << ",\n      \"calls\": " << count << ",\n";
+        out << "      \"total\": " << sum << ",\n";
+        snprintf(buf, sizeof(buf), "%.1f", static_cast<double>(sum) / count);
+        out << "      \"mean\": " << buf << ",\n";
+
+        // Quantiles are the top of the bucket holding them, never above the max
+        uint64_t seen = 0;
+        int q = 0;
+        for (int b = 0; b < N_BUCKETS && q < N_QUANTILES; b++)
+        {
+            seen += buckets[b];
+            while (q < N_QUANTILES && seen > 0 && seen >= QUANTILES[q] * count)
+            {
+                uint64_t top = bucketTop(b);
+                out << "      \"" << QUANTILE_NAMES[q] << "\": " << (top < max ? top : max) << ",\n";
+                q++;
+            }
+        }
+        out << "      \"max\": " << max << ",\n";
+
+        // Non-empty buckets as [largest value, calls]
+        out << "      \"histogram\": [";
+        bool firstBucket = true;
+        for (int b = 0; b < N_BUCKETS; b++)
+        {
+            if (buckets[b] == 0)
+                continue;
+            out << (firstBucket ? "" : ", ") << '[' << bucketTop(b) << ", " << buckets[b] << ']';
+            firstBucket = false;
+        }
+        out << "]\n    }";
+        firstProbe = false;
+    }
+    out << "\n  ]\n}\n";
+}
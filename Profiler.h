@@ -0,0 +1,89 @@
+#ifndef PROFILER_INCLUDED
+#define PROFILER_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+// Latency histograms for the player and board entry points and the phases
+// of a game, for finding where time goes in the tail as well as on
+// average.
+//
+// Code marks what it wants timed with a probe:
+//
+//   Point GoodPlayer::recommendAttack()
+//   {
+//       PROFILE_SCOPE("good.recommendAttack");
+//       ...
+//
+// Each thread records into histograms of its own, with no locks and no
+// shared writes, so probes cost a clock read at each end and nothing else.
+// writeJson adds up every thread's histograms.  Profiling starts disabled;
+// until enable(true) a probe costs one predictable branch.
+//
+// Histograms are log-linear: exact below 16 ns, then 8 buckets per power
+// of two, so a percentile is within 12.5% of the true value.
+class Profiler
+{
+public:
+    static void enable(bool on) { s_enabled.store(on, std::memory_order_relaxed); }
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Number of the probe called name, registering it on first use.  name
+    // must outlive the program, e.g. a string literal.
+    static int probe(const char* name);
+
+    // Add one call of nanos to the calling thread's histogram of probe
+    static void record(int probe, uint64_t nanos);
+
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Clear every thread's histograms
+    static void reset();
+
+    // Merge every thread's histograms and write them out, probes in the
+    // order they were registered.  Safe while other threads record; their
+    // calls in progress may or may not be counted.
+    static void writeJson(std::ostream& out);
+
+    static constexpr int MAX_PROBES = 64;
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// Times its own lifetime into a probe, if profiling was enabled when it began
+class ProfileScope
+{
+public:
+    explicit ProfileScope(int probe)
+        : m_probe(probe), m_start(Profiler::enabled() ? Profiler::now() : 0)
+    {}
+    ~ProfileScope()
+    {
+        if (m_start != 0)
+            Profiler::record(m_probe, Profiler::now() - m_start);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    int m_probe;
+    uint64_t m_start;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+// Time the rest of the enclosing block into the probe called name
+#define PROFILE_SCOPE(name) \
+    static const int PROFILE_CONCAT(profileProbe_, __LINE__) = Profiler::probe(name); \
+    ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileProbe_, __LINE__))
+
+#endif // PROFILER_INCLUDED
@@ -0,0 +1,116 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+ThreadPool::ThreadPool(int nThreads)
+    : m_stopping(false)
+{
+    if (nThreads <= 0)
+        nThreads = max(1u, thread::hardware_concurrency());
+    for (int t = 0; t < nThreads; t++)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (size_t t = 0; t < m_workers.size(); t++)
+        m_workers[t].join();
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        function<void()> job;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty())
+                return;
+            job = move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
+
+namespace
+{
+    // Shared by the caller and every helper of one parallelFor call.  Helpers
+    // that only start after the loop is finished still hold a reference, so
+    // the state outlives the call.
+    struct LoopState
+    {
+        LoopState(int count, const function<void(int)>& fn)
+            : n(count), next(0), finished(0), task(fn)
+        {}
+
+        // Claim and run indices until none are left
+        void work()
+        {
+            int done = 0;
+            for (int i = next++; i < n; i = next++)
+            {
+                task(i);
+                ++done;
+            }
+            if (done > 0 && (finished += done) == n)
+            {
+                lock_guard<mutex> lock(m);
+                allDone.notify_all();
+            }
+        }
+
+        const int n;
+        atomic<int> next;
+        atomic<int> finished;
+        function<void(int)> task;
+        mutex m;
+        condition_variable allDone;
+    };
+}
+
+void ThreadPool::parallelFor(int n, const function<void(int)>& task, int maxThreads)
+{
+    if (n <= 0)
+        return;
+
+    int helpers = min(n - 1, size());
+    if (maxThreads > 0)
+        helpers = min(helpers, maxThreads - 1);
+
+    // Nobody to share with: skip the shared state entirely
+    if (helpers == 0)
+    {
+        for (int i = 0; i < n; i++)
+            task(i);
+        return;
+    }
+
+    shared_ptr<LoopState> state = make_shared<LoopState>(n, task);
+    {
+        lock_guard<mutex> lock(m_mutex);
+        for (int h = 0; h < helpers; h++)
+            m_jobs.push_back([state] { state->work(); });
+    }
+    m_wake.notify_all();
+
+    state->work();
+
+    unique_lock<mutex> lock(state->m);
+    state->allDone.wait(lock, [&state] { return state->finished == state->n; });
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool(0);
+    return pool;
+}
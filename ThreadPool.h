@@ -0,0 +1,44 @@
+#ifndef THREADPOOL_INCLUDED
+#define THREADPOOL_INCLUDED
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads shared by everything that wants to split
+// work across cores.  Any thread may call parallelFor, including several
+// at once; the calling thread always works on its own loop too, so a call
+// makes progress even when every worker is busy.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int nThreads);      // nThreads <= 0 means one per hardware thread
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(m_workers.size()); }
+
+    // Run task(i) for every i in [0, n) and return once all have finished.
+    // At most maxThreads threads (including the caller) work on the loop;
+    // maxThreads <= 0 means no limit.
+    void parallelFor(int n, const std::function<void(int)>& task, int maxThreads = 0);
+
+    // Pool sized to the machine, created on first use
+    static ThreadPool& shared();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()> > m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping;
+};
+
+#endif // THREADPOOL_INCLUDED
@@ -0,0 +1,32 @@
+#include "ToolSupport.h"
+#include "Game.h"
+#include <cstdlib>
+#include <sstream>
+
+using namespace std;
+
+bool parseFleet(const string& text, vector<int>& fleet)
+{
+    fleet.clear();
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ','))
+    {
+        int len = atoi(item.c_str());
+        if (len < 1)
+            return false;
+        fleet.push_back(len);
+    }
+    return !fleet.empty();
+}
+
+bool addFleet(Game& g, const vector<int>& fleet)
+{
+    static const char symbols[] = "ABCDEFGHIJKLMNPQRSTUVWYZabcdefghijklmnpqrstuvwxyz";
+    if (fleet.size() >= sizeof(symbols))
+        return false;
+    for (size_t k = 0; k < fleet.size(); k++)
+        if (!g.addShip(fleet[k], symbols[k], "ship " + to_string(k)))
+            return false;
+    return true;
+}
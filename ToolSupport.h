@@ -0,0 +1,57 @@
+#ifndef TOOLSUPPORT_INCLUDED
+#define TOOLSUPPORT_INCLUDED
+
+#include "Player.h"
+#include "globals.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+class Board;
+class Game;
+
+// Pieces the command-line tools (tournament, roundrobin, bench, replay and
+// book) share.
+
+// Parses comma-separated ship lengths such as "5,4,3,3,2".  Returns false
+// on an empty list or a length below 1.
+bool parseFleet(const std::string& text, std::vector<int>& fleet);
+
+// Adds ships of the given lengths to g, named "ship 0", "ship 1", ...  The
+// symbols they get are only needed to satisfy Game::addShip.  Returns false
+// if there are more ships than symbols or g rejects one.
+bool addFleet(Game& g, const std::vector<int>& fleet);
+
+// Wraps a player to count the shots it takes.  Everything else is forwarded.
+class CountingPlayer : public Player
+{
+public:
+    CountingPlayer(Player* inner, const Game& g)
+        : Player(inner->name(), g), m_inner(inner), m_shots(0)
+    {}
+    ~CountingPlayer() { delete m_inner; }
+
+    int shots() const { return m_shots; }
+
+    virtual bool placeShips(Board& b) { return m_inner->placeShips(b); }
+    virtual Point recommendAttack() { return m_inner->recommendAttack(); }
+    virtual bool tryAttack(Point& p, const std::function<void()>& ready) { return m_inner->tryAttack(p, ready); }
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+        bool shipDestroyed, int shipId)
+    {
+        ++m_shots;
+        m_inner->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+    }
+    virtual void recordAttackByOpponent(Point p) { m_inner->recordAttackByOpponent(p); }
+    virtual void reset()
+    {
+        m_shots = 0;
+        m_inner->reset();
+    }
+
+private:
+    Player* m_inner;
+    int m_shots;
+};
+
+#endif // TOOLSUPPORT_INCLUDED
@@ -0,0 +1,35 @@
+#ifndef ZOBRIST_INCLUDED
+#define ZOBRIST_INCLUDED
+
+#include "globals.h"
+#include <cstdint>
+
+// Keys for a Zobrist hash of what an attacker has seen of a board: every
+// miss, every hit and every sunk ship contributes one key, combined with
+// xor.  Applying the key of a shot again takes it back out, so the hash
+// follows attacks and their undoing one shot at a time.
+//
+// Keys are computed from the cell or shipId rather than stored, so they
+// need no table and are the same in every process; a hash saved by one run
+// can be looked up by another with the same board size and fleet.
+class Zobrist
+{
+public:
+    static uint64_t miss(int cell) { return key(4 * static_cast<uint64_t>(cell)); }
+    static uint64_t hit(int cell)  { return key(4 * static_cast<uint64_t>(cell) + 1); }
+    static uint64_t sunk(int shipId) { return key(4 * static_cast<uint64_t>(shipId) + 2); }
+
+    // Everything one shot at cell reveals, as reported to the attacker
+    static uint64_t shot(int cell, bool shotHit, bool shipDestroyed, int shipId)
+    {
+        if (!shotHit)
+            return miss(cell);
+        return shipDestroyed ? hit(cell) ^ sunk(shipId) : hit(cell);
+    }
+
+private:
+    // Rng::mix is a bijection, so distinct inputs never share a key
+    static uint64_t key(uint64_t n) { return Rng::mix(0x5a0b417c3e9d26f1ULL + n); }
+};
+
+#endif // ZOBRIST_INCLUDED
@@ -0,0 +1,576 @@
+// Benchmarks for the game engine and the AI players.
+//
+// Each benchmark is run untimed for a warmup period, then timed over a
+// number of samples.  A sample repeats the benchmark's round until it has
+// taken at least the sample time, and its result is the time per operation.
+// Work a round needs to set up its state (fresh boards, players brought to
+// a given point in the game) is excluded from the timing.
+//
+//   bench [-r rows] [-c cols] [-f lengths] [-p players] [-s seed]
+//         [-n samples] [-m ms per sample] [-w warmup ms] [-b filter] [-o file]
+//
+// Results go to the JSON file given with -o (standard output by default);
+// a readable summary goes to standard error.  A recorded file identifies
+// its configuration, so runs on different board sizes and different
+// revisions can be compared directly.
+//
+// e.g.  bench -r 20 -c 20 -p good,montecarlo:500 -o bench-20x20.json
+
+#include "Board.h"
+#include "Game.h"
+#include "GameEvents.h"
+#include "Lockstep.h"
+#include "PlacementSolver.h"
+#include "Player.h"
+#include "ToolSupport.h"
+#include "globals.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct BenchConfig
+{
+    int rows = 10;
+    int cols = 10;
+    vector<int> fleet = { 5, 4, 3, 3, 2 };
+    vector<string> players = { "awful", "mediocre", "good", "montecarlo" };
+    uint64_t seed = 1;                      // fixed by default so runs do identical work
+    int nSamples = 15;
+    double sampleMs = 20;
+    double warmupMs = 100;
+    string filter;                          // only run benchmarks whose name contains this
+    string output;                          // JSON file, or standard output if empty
+};
+
+struct BenchResult
+{
+    string name;
+    int nSamples;
+    long opsPerSample;                      // operations timed in the first sample
+    double mean, median, stddev, min, max;  // nanoseconds per operation
+};
+
+// Accumulates time only while running, so a round can leave its setup out
+class Stopwatch
+{
+public:
+    Stopwatch() : m_ns(0) {}
+    void start() { m_start = chrono::steady_clock::now(); }
+    void stop() { m_ns += chrono::duration<double, nano>(chrono::steady_clock::now() - m_start).count(); }
+    double ns() const { return m_ns; }
+private:
+    chrono::steady_clock::time_point m_start;
+    double m_ns;
+};
+
+// One round of a benchmark: times its operations with the stopwatch and
+// returns how many it performed
+typedef function<long(Stopwatch&)> Round;
+
+// Keeps results the compiler could otherwise discard
+static volatile long g_sink;
+
+static bool parseList(const string& text, vector<string>& items)
+{
+    items.clear();
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return !items.empty();
+}
+
+static bool parseArgs(int argc, char* argv[], BenchConfig& cfg)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string opt = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        string val = argv[++i];
+        if (opt == "-r")
+            cfg.rows = atoi(val.c_str());
+        else if (opt == "-c")
+            cfg.cols = atoi(val.c_str());
+        else if (opt == "-s")
+            cfg.seed = strtoull(val.c_str(), nullptr, 0);
+        else if (opt == "-n")
+            cfg.nSamples = atoi(val.c_str());
+        else if (opt == "-m")
+            cfg.sampleMs = atof(val.c_str());
+        else if (opt == "-w")
+            cfg.warmupMs = atof(val.c_str());
+        else if (opt == "-b")
+            cfg.filter = val;
+        else if (opt == "-o")
+            cfg.output = val;
+        else if (opt == "-f")
+        {
+            if (!parseFleet(val, cfg.fleet))
+                return false;
+        }
+        else if (opt == "-p")
+        {
+            if (!parseList(val, cfg.players))
+                return false;
+        }
+        else
+            return false;
+    }
+    return cfg.rows >= 1 && cfg.rows <= MAXROWS && cfg.cols >= 1 && cfg.cols <= MAXCOLS &&
+        cfg.nSamples > 0 && cfg.sampleMs > 0 && cfg.warmupMs >= 0;
+}
+
+static void usage()
+{
+    cerr << "Usage: bench [-r rows] [-c cols] [-f lengths] [-p players] [-s seed]" << endl
+        << "             [-n samples] [-m ms per sample] [-w warmup ms] [-b filter] [-o file]" << endl
+        << "  -f takes comma-separated ship lengths (default 5,4,3,3,2)" << endl
+        << "  -p takes comma-separated player types (default awful,mediocre,good,montecarlo)" << endl;
+}
+
+//******************** Running and reporting ************************
+
+class BenchRunner
+{
+public:
+    BenchRunner(const BenchConfig& cfg) : m_cfg(cfg) {}
+
+    void run(const string& name, const Round& round);
+    void writeJson(ostream& out) const;
+
+private:
+    static constexpr int MAX_IDLE_ROUNDS = 100;     // rounds in a row that may time nothing
+    static constexpr int MAX_SETUP_FACTOR = 10;     // wall time of a sample, in sample times
+
+    const BenchConfig& m_cfg;
+    vector<BenchResult> m_results;
+};
+
+void BenchRunner::run(const string& name, const Round& round)
+{
+    if (name.find(m_cfg.filter) == string::npos)
+        return;
+
+    // Warm caches, branch predictors and the thread pool.  A benchmark whose
+    // rounds never get to time anything (say, every game ends before the
+    // stage it measures) is skipped.
+    auto warmupEnd = chrono::steady_clock::now() + chrono::duration<double, milli>(m_cfg.warmupMs);
+    long warmupOps = 0;
+    int rounds = 0;
+    while (warmupOps == 0 ? rounds < MAX_IDLE_ROUNDS : chrono::steady_clock::now() < warmupEnd)
+    {
+        Stopwatch sw;
+        warmupOps += round(sw);
+        rounds++;
+    }
+    if (warmupOps == 0)
+    {
+        fprintf(stderr, "  %-44s skipped: nothing to time\n", name.c_str());
+        return;
+    }
+
+    BenchResult res;
+    res.name = name;
+    res.nSamples = m_cfg.nSamples;
+    res.opsPerSample = 0;
+
+    // A sample also ends once its rounds have run for much longer than the
+    // sample time, so benchmarks dominated by setup still finish
+    vector<double> perOp;
+    double targetNs = m_cfg.sampleMs * 1e6;
+    auto wallLimit = chrono::duration<double, milli>(m_cfg.sampleMs * MAX_SETUP_FACTOR);
+    for (int s = 0; s < m_cfg.nSamples; s++)
+    {
+        Stopwatch sw;
+        long ops = 0;
+        auto sampleEnd = chrono::steady_clock::now() + wallLimit;
+        for (int idle = 0; sw.ns() < targetNs && idle < MAX_IDLE_ROUNDS; )
+        {
+            long n = round(sw);
+            ops += n;
+            idle = (n == 0 ? idle + 1 : 0);
+            if (ops > 0 && chrono::steady_clock::now() >= sampleEnd)
+                break;
+        }
+        if (s == 0)
+            res.opsPerSample = ops;
+        perOp.push_back(sw.ns() / max(1L, ops));
+    }
+
+    double sum = 0;
+    for (size_t k = 0; k < perOp.size(); k++)
+        sum += perOp[k];
+    res.mean = sum / perOp.size();
+    double sq = 0;
+    for (size_t k = 0; k < perOp.size(); k++)
+        sq += (perOp[k] - res.mean) * (perOp[k] - res.mean);
+    res.stddev = (perOp.size() > 1 ? sqrt(sq / (perOp.size() - 1)) : 0);
+    sort(perOp.begin(), perOp.end());
+    size_t mid = perOp.size() / 2;
+    res.median = (perOp.size() % 2 == 1 ? perOp[mid] : (perOp[mid - 1] + perOp[mid]) / 2);
+    res.min = perOp.front();
+    res.max = perOp.back();
+    m_results.push_back(res);
+
+    fprintf(stderr, "  %-44s %12.1f ns/op  median %12.1f  +- %5.1f%%\n",
+        name.c_str(), res.mean, res.median, res.mean > 0 ? 100 * res.stddev / res.mean : 0.0);
+}
+
+// Player types such as montecarlo:500 are used as JSON strings, so escape them
+static string jsonString(const string& s)
+{
+    string out = "\"";
+    for (size_t k = 0; k < s.size(); k++)
+    {
+        if (s[k] == '"' || s[k] == '\\')
+            out += '\\';
+        out += s[k];
+    }
+    return out + '"';
+}
+
+void BenchRunner::writeJson(ostream& out) const
+{
+    char buf[64];
+    out << "{\n  \"config\": {\n";
+    out << "    \"rows\": " << m_cfg.rows << ",\n";
+    out << "    \"cols\": " << m_cfg.cols << ",\n";
+    out << "    \"fleet\": [";
+    for (size_t k = 0; k < m_cfg.fleet.size(); k++)
+        out << (k > 0 ? ", " : "") << m_cfg.fleet[k];
+    out << "],\n";
+    out << "    \"seed\": " << m_cfg.seed << ",\n";
+    out << "    \"samples\": " << m_cfg.nSamples << ",\n";
+    out << "    \"sampleMs\": " << m_cfg.sampleMs << ",\n";
+    out << "    \"warmupMs\": " << m_cfg.warmupMs << "\n";
+    out << "  },\n  \"benchmarks\": [";
+    for (size_t k = 0; k < m_results.size(); k++)
+    {
+        const BenchResult& r = m_results[k];
+        out << (k > 0 ? "," : "") << "\n    {\n";
+        out << "      \"name\": " << jsonString(r.name) << ",\n";
+        out << "      \"unit\": \"ns/op\",\n";
+        out << "      \"samples\": " << r.nSamples << ",\n";
+        out << "      \"opsPerSample\": " << r.opsPerSample << ",\n";
+        const char* fields[] = { "mean", "median", "stddev", "min", "max" };
+        const double values[] = { r.mean, r.median, r.stddev, r.min, r.max };
+        for (int f = 0; f < 5; f++)
+        {
+            snprintf(buf, sizeof(buf), "%.3f", values[f]);
+            out << "      \"" << fields[f] << "\": " << buf << (f < 4 ? ",\n" : "\n");
+        }
+        out << "    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+//******************** Benchmarks ***********************************
+
+// A fresh game of the configured size and fleet
+static unique_ptr<Game> makeGame(const BenchConfig& cfg, uint64_t seed)
+{
+    unique_ptr<Game> g(new Game(cfg.rows, cfg.cols, seed));
+    addFleet(*g, cfg.fleet);
+    return g;
+}
+
+static void benchBoard(BenchRunner& runner, const BenchConfig& cfg)
+{
+    unique_ptr<Game> g = makeGame(cfg, cfg.seed);
+    int nCells = cfg.rows * cfg.cols;
+
+    // One fixed layout and a fixed shooting order for every round
+    Layout layout;
+    if (PlacementSolver(*g).solve(g->rng(), layout) != PlacementSolver::PLACED)
+    {
+        cerr << "The fleet can't be placed; skipping board benchmarks" << endl;
+        return;
+    }
+    vector<Point> order;
+    for (int i = 0; i < nCells; i++)
+        order.push_back(Point(i / cfg.cols, i % cfg.cols));
+    g->rng().shuffle(order.begin(), order.end());
+
+    Board b(*g);
+
+    runner.run("board.attack", [&](Stopwatch& sw) {
+        b.clear();
+        PlacementSolver::apply(layout, b);
+        bool shotHit, shipDestroyed;
+        int shipId;
+        long hits = 0;
+        sw.start();
+        for (int i = 0; i < nCells; i++)
+            hits += b.attack(order[i], shotHit, shipDestroyed, shipId) && shotHit;
+        sw.stop();
+        g_sink = hits;
+        return static_cast<long>(nCells);
+    });
+
+    runner.run("board.unattack", [&](Stopwatch& sw) {
+        b.clear();
+        PlacementSolver::apply(layout, b);
+        bool shotHit, shipDestroyed;
+        int shipId;
+        for (int i = 0; i < nCells; i++)
+            b.attack(order[i], shotHit, shipDestroyed, shipId);
+        long undone = 0;
+        sw.start();
+        for (int i = 0; i < nCells; i++)
+            undone += b.unattack();
+        sw.stop();
+        g_sink = undone + static_cast<long>(b.stateHash());
+        return static_cast<long>(nCells);
+    });
+
+    runner.run("board.placeShip", [&](Stopwatch& sw) {
+        b.clear();
+        long placed = 0;
+        sw.start();
+        for (size_t k = 0; k < layout.size(); k++)
+            placed += b.placeShip(layout[k].topOrLeft, layout[k].shipId, layout[k].dir);
+        sw.stop();
+        g_sink = placed;
+        return static_cast<long>(layout.size());
+    });
+
+    // Half the board shot, so the answer isn't known up front
+    b.clear();
+    PlacementSolver::apply(layout, b);
+    for (int i = 0; i < nCells / 2; i++)
+    {
+        bool shotHit, shipDestroyed;
+        int shipId;
+        b.attack(order[i], shotHit, shipDestroyed, shipId);
+    }
+    runner.run("board.allShipsDestroyed", [&](Stopwatch& sw) {
+        const int n = 1000;
+        long destroyed = 0;
+        sw.start();
+        for (int k = 0; k < n; k++)
+            destroyed += b.allShipsDestroyed();
+        sw.stop();
+        g_sink = destroyed;
+        return static_cast<long>(n);
+    });
+}
+
+static void benchPlacement(BenchRunner& runner, const BenchConfig& cfg, const string& type)
+{
+    unique_ptr<Game> g = makeGame(cfg, cfg.seed);
+    unique_ptr<Player> p(createPlayer(type, type, *g));
+    Board b(*g);
+
+    runner.run("player." + type + ".placeShips", [&](Stopwatch& sw) {
+        b.clear();
+        sw.start();
+        bool placed = p->placeShips(b);
+        sw.stop();
+        g_sink = placed;
+        return 1L;
+    });
+}
+
+// How far into the game a targeting benchmark starts
+enum Stage { EARLY, MID, LATE };
+
+// Let a fresh player fire at b until the stage is reached: nothing for
+// EARLY, half of the fleet's cells hit for MID, and every ship but one
+// sunk for LATE.  Returns false if the game ended first.
+static bool advance(Player& p, Board& b, const Game& g, Stage stage)
+{
+    int area = 0;
+    for (int s = 0; s < g.nShips(); s++)
+        area += g.shipLength(s);
+    int hitsWanted = (stage == MID ? (area + 1) / 2 : area);
+    int sunkWanted = (stage == LATE ? g.nShips() - 1 : g.nShips());
+
+    int hits = 0;
+    int sunk = 0;
+    for (int shots = 0; stage != EARLY && hits < hitsWanted && sunk < sunkWanted; shots++)
+    {
+        if (shots > 2 * g.rows() * g.cols())
+            return false;
+        bool shotHit = false;
+        bool shipDestroyed = false;
+        int shipId = -1;
+        Point target = p.recommendAttack();
+        bool valid = b.attack(target, shotHit, shipDestroyed, shipId);
+        p.recordAttackResult(target, valid, shotHit, shipDestroyed, shipId);
+        hits += (valid && shotHit);
+        sunk += (valid && shipDestroyed);
+    }
+    return !b.allShipsDestroyed();
+}
+
+static void benchTargeting(BenchRunner& runner, const BenchConfig& cfg, const string& type)
+{
+    static const char* const stageNames[] = { "early", "mid", "late" };
+
+    unique_ptr<Game> g = makeGame(cfg, cfg.seed);
+    Layout layout;
+    if (PlacementSolver(*g).solve(g->rng(), layout) != PlacementSolver::PLACED)
+        return;
+    Board b(*g);
+
+    for (int stage = EARLY; stage <= LATE; stage++)
+    {
+        // Each round brings a new player to the stage against the same
+        // layout, then times the next shot
+        Point target;
+        unique_ptr<Player> p;
+        auto setUp = [&]() {
+            b.clear();
+            PlacementSolver::apply(layout, b);
+            p.reset(createPlayer(type, type, *g));
+            return advance(*p, b, *g, static_cast<Stage>(stage));
+        };
+
+        string prefix = "player." + type + ".";
+        string suffix = string(".") + stageNames[stage];
+        runner.run(prefix + "recommendAttack" + suffix, [&](Stopwatch& sw) {
+            if (!setUp())
+                return 0L;
+            sw.start();
+            target = p->recommendAttack();
+            sw.stop();
+            g_sink = target.r + target.c;
+            return 1L;
+        });
+        runner.run(prefix + "recordAttackResult" + suffix, [&](Stopwatch& sw) {
+            if (!setUp())
+                return 0L;
+            target = p->recommendAttack();
+            bool shotHit = false;
+            bool shipDestroyed = false;
+            int shipId = -1;
+            bool valid = b.attack(target, shotHit, shipDestroyed, shipId);
+            sw.start();
+            p->recordAttackResult(target, valid, shotHit, shipDestroyed, shipId);
+            sw.stop();
+            return 1L;
+        });
+    }
+}
+
+static void benchGames(BenchRunner& runner, const BenchConfig& cfg, const string& type)
+{
+    unique_ptr<Game> g = makeGame(cfg, cfg.seed);
+    NullEventSink quiet;
+    long k = 0;
+
+    runner.run("game." + type + "-vs-" + type, [&](Stopwatch& sw) {
+        g->reseed(Rng::mix(cfg.seed + k++));
+        unique_ptr<Player> p1(createPlayer(type, type + " 1", *g));
+        unique_ptr<Player> p2(createPlayer(type, type + " 2", *g));
+        sw.start();
+        Player* winner = g->play(p1.get(), p2.get(), quiet);
+        sw.stop();
+        g_sink = (winner == p1.get());
+        return 1L;
+    });
+}
+
+// The same games as benchGames, a batch at a time in lockstep, for players
+// the engine can run
+static void benchLockstepGames(BenchRunner& runner, const BenchConfig& cfg, const string& type)
+{
+    unique_ptr<Game> g = makeGame(cfg, cfg.seed);
+    LockstepEngine::Targeting targeting;
+    if (!LockstepEngine::targetingOf(type, targeting) || !LockstepEngine::supports(*g))
+        return;
+    unique_ptr<Player> p1(createPlayer(type, type + " 1", *g));
+    unique_ptr<Player> p2(createPlayer(type, type + " 2", *g));
+    Board b1(*g);
+    Board b2(*g);
+    LockstepEngine engine(*g, targeting, targeting);
+    long k = 0;
+
+    runner.run("game.lockstep." + type + "-vs-" + type, [&](Stopwatch& sw) {
+        sw.start();
+        int nLanes = 0;
+        for (int l = 0; l < LockstepEngine::LANES; l++)
+        {
+            g->reseed(Rng::mix(cfg.seed + k++));
+            p1->reset();
+            p2->reset();
+            b1.reset();
+            b2.reset();
+            if (p1->placeShips(b1) && p2->placeShips(b2) && engine.load(nLanes, b1, b2))
+                nLanes++;
+        }
+        engine.run(nLanes);
+        sw.stop();
+        g_sink = engine.winner(0);
+        return static_cast<long>(LockstepEngine::LANES);
+    });
+}
+
+int main(int argc, char* argv[])
+{
+    BenchConfig cfg;
+    if (!parseArgs(argc, argv, cfg))
+    {
+        usage();
+        return 1;
+    }
+
+    // Validate the configuration before running anything
+    {
+        Game g(cfg.rows, cfg.cols);
+        if (!addFleet(g, cfg.fleet))
+            return 1;
+        for (size_t i = 0; i < cfg.players.size(); i++)
+        {
+            Player* p = createPlayer(cfg.players[i], "check", g);
+            bool ok = (p != nullptr && !p->isHuman());
+            delete p;
+            if (!ok)
+            {
+                cerr << "Unknown or non-AI player type " << cfg.players[i] << endl;
+                return 1;
+            }
+        }
+    }
+
+    fprintf(stderr, "%dx%d board, %d ships, seed %llu\n", cfg.rows, cfg.cols,
+        static_cast<int>(cfg.fleet.size()), static_cast<unsigned long long>(cfg.seed));
+
+    BenchRunner runner(cfg);
+    benchBoard(runner, cfg);
+    for (size_t i = 0; i < cfg.players.size(); i++)
+        benchPlacement(runner, cfg, cfg.players[i]);
+    for (size_t i = 0; i < cfg.players.size(); i++)
+        benchTargeting(runner, cfg, cfg.players[i]);
+    for (size_t i = 0; i < cfg.players.size(); i++)
+        benchGames(runner, cfg, cfg.players[i]);
+    for (size_t i = 0; i < cfg.players.size(); i++)
+        benchLockstepGames(runner, cfg, cfg.players[i]);
+
+    if (cfg.output.empty())
+        runner.writeJson(cout);
+    else
+    {
+        ofstream out(cfg.output.c_str());
+        if (!out)
+        {
+            cerr << "Can't write " << cfg.output << endl;
+            return 1;
+        }
+        runner.writeJson(out);
+    }
+    return 0;
+}
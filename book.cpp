@@ -0,0 +1,195 @@
+// Builds an opening book (see OpeningBook.h) for one player type, board
+// size and fleet.
+//
+//   book <player> -o bookfile [-r rows] [-c cols] [-f lengths]
+//        [-d plies] [-n games] [-m min visits] [-s seed]
+//
+// The player is shown the first plies shots of many games against random
+// fleets.  The first time a game reaches an observed state, the player
+// works out its shot there and the book keeps it; whenever a later game
+// reaches the same state the book's shot is taken without asking again, so
+// every game explores along the book's own line.  States reached in at
+// least min visits games are written out.
+//
+// A slow, strong player makes the best book, e.g. montecarlo with many
+// samples; any player type can then use it with tournament -b.
+//
+// e.g.  book montecarlo:50000 -d 8 -n 20000 -o 10x10.book
+//       tournament montecarlo good -b 10x10.book
+
+#include "Board.h"
+#include "Game.h"
+#include "OpeningBook.h"
+#include "PlacementSolver.h"
+#include "Player.h"
+#include "ToolSupport.h"
+#include "globals.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+struct BookConfig
+{
+    string type;
+    string output;
+    int rows = 10;
+    int cols = 10;
+    vector<int> fleet = { 5, 4, 3, 3, 2 };
+    int plies = 8;                          // shots per game looked up in the book
+    int nGames = 10000;
+    int minVisits = 1;                      // games that must reach a state for it to be kept
+    uint64_t seed = 1;
+};
+
+// A state the book has a shot for
+struct Position
+{
+    int cell;
+    int visits;                             // games that reached the state
+};
+
+static void usage()
+{
+    cerr << "Usage: book <player> -o bookfile [-r rows] [-c cols] [-f lengths]" << endl
+        << "            [-d plies] [-n games] [-m min visits] [-s seed]" << endl
+        << "  -f takes comma-separated ship lengths (default 5,4,3,3,2)" << endl;
+}
+
+static bool parseArgs(int argc, char* argv[], BookConfig& cfg)
+{
+    if (argc < 2)
+        return false;
+    cfg.type = argv[1];
+
+    for (int i = 2; i < argc; i++)
+    {
+        string opt = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        string val = argv[++i];
+        if (opt == "-o")
+            cfg.output = val;
+        else if (opt == "-r")
+            cfg.rows = atoi(val.c_str());
+        else if (opt == "-c")
+            cfg.cols = atoi(val.c_str());
+        else if (opt == "-d")
+            cfg.plies = atoi(val.c_str());
+        else if (opt == "-n")
+            cfg.nGames = atoi(val.c_str());
+        else if (opt == "-m")
+            cfg.minVisits = atoi(val.c_str());
+        else if (opt == "-s")
+            cfg.seed = strtoull(val.c_str(), nullptr, 0);
+        else if (opt == "-f")
+        {
+            if (!parseFleet(val, cfg.fleet))
+                return false;
+        }
+        else
+            return false;
+    }
+    return !cfg.output.empty() && cfg.plies > 0 && cfg.plies <= 0xFFFF && cfg.nGames > 0 && cfg.minVisits > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    BookConfig cfg;
+    if (!parseArgs(argc, argv, cfg))
+    {
+        usage();
+        return 1;
+    }
+
+    if (cfg.rows < 1 || cfg.rows > MAXROWS || cfg.cols < 1 || cfg.cols > MAXCOLS)
+    {
+        cerr << "Board must be between 1x1 and " << MAXROWS << 'x' << MAXCOLS << endl;
+        return 1;
+    }
+
+    Game g(cfg.rows, cfg.cols, cfg.seed);
+    if (!addFleet(g, cfg.fleet))
+        return 1;
+    Player* p = createPlayer(cfg.type, cfg.type, g);
+    if (p == nullptr || p->isHuman())
+    {
+        cerr << "Unknown or non-AI player type " << cfg.type << endl;
+        delete p;
+        return 1;
+    }
+
+    unordered_map<uint64_t, Position> book;
+    Board b(g);
+    long long computed = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int k = 0; k < cfg.nGames; k++)
+    {
+        // Every fleet layout is as likely as any other
+        g.reseed(Rng::mix(cfg.seed + k));
+        p->reset();
+        b.reset();
+        // A scratch only gives its memory back when it goes away, so each
+        // game has its own
+        PlacementSolver::Scratch scratch;
+        PlacementSolver solver(g, &scratch);
+        Layout layout(&scratch);
+        if (solver.solve(g.rng(), layout) != PlacementSolver::PLACED || !PlacementSolver::apply(layout, b))
+        {
+            cerr << "The fleet cannot be placed on a " << cfg.rows << 'x' << cfg.cols << " board" << endl;
+            delete p;
+            return 1;
+        }
+
+        for (int ply = 0; ply < cfg.plies && !b.allShipsDestroyed(); ply++)
+        {
+            uint64_t state = b.stateHash();
+            auto found = book.find(state);
+            Point shot;
+            if (found != book.end())
+            {
+                found->second.visits++;
+                shot = Point(found->second.cell / cfg.cols, found->second.cell % cfg.cols);
+            }
+            else
+            {
+                shot = p->recommendAttack();
+                if (!g.isValid(shot))
+                    break;
+                book.emplace(state, Position{ shot.r * cfg.cols + shot.c, 1 });
+                computed++;
+            }
+
+            bool shotHit = false, shipDestroyed = false;
+            int shipId = -1;
+            bool valid = b.attack(shot, shotHit, shipDestroyed, shipId);
+            p->recordAttackResult(shot, valid, shotHit, shipDestroyed, shipId);
+            if (!valid)
+                break;
+        }
+    }
+    delete p;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<OpeningBookEntry> entries;
+    for (auto it = book.begin(); it != book.end(); ++it)
+        if (it->second.visits >= cfg.minVisits)
+            entries.push_back(OpeningBookEntry{ it->first, static_cast<uint32_t>(it->second.cell) });
+    if (!OpeningBook::write(cfg.output, g, cfg.type, cfg.plies, entries))
+    {
+        cerr << "Cannot write " << cfg.output << endl;
+        return 1;
+    }
+
+    printf("%d games, %s, %dx%d board, %d ships, %d plies\n", cfg.nGames, cfg.type.c_str(),
+        cfg.rows, cfg.cols, static_cast<int>(cfg.fleet.size()), cfg.plies);
+    printf("  %lld positions worked out in %.3f s, %zu kept in %s\n",
+        computed, seconds, entries.size(), cfg.output.c_str());
+    return 0;
+}
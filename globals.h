@@ -1,10 +1,16 @@
 #ifndef GLOBALS_INCLUDED
 #define GLOBALS_INCLUDED
 
+#include <cstddef>
+#include <cstdint>
 #include <random>
+#include <utility>
 
-const int MAXROWS = 10;
-const int MAXCOLS = 10;
+const int MAXROWS = 1024;
+const int MAXCOLS = 1024;
+
+// Boards with at most this many cells use fixed-size, inline storage
+const int SMALL_BOARD_CELLS = 128;
 
 enum Direction {
     HORIZONTAL, VERTICAL
@@ -21,15 +27,109 @@ public:
 };
 
 
-// Return a uniformly distributed random int from 0 to limit-1
-inline int randInt(int limit)
+// Small-state pseudo-random generator (xoshiro256**) with an explicit
+// 64-bit seed.  Each Game owns one, so games never share random state and
+// any game can be replayed from its seed.
+class Rng
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
-    if (limit < 1)
-        limit = 1;
-    std::uniform_int_distribution<> distro(0, limit - 1);
-    return distro(generator);
-}
+public:
+    explicit Rng(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed)
+    {
+        // Expand the seed into the full state with splitmix64
+        for (int k = 0; k < 4; k++)
+        {
+            seed += 0x9e3779b97f4a7c15ULL;
+            s[k] = mix(seed);
+        }
+    }
+
+    uint64_t next()
+    {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Return a uniformly distributed random int from 0 to limit-1
+    int nextInt(int limit)
+    {
+        if (limit < 1)
+            limit = 1;
+        return bounded(next(), static_cast<uint32_t>(limit));
+    }
+
+    // Fill out[0..n) with raw 64-bit draws
+    void fill(uint64_t* out, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+            out[i] = next();
+    }
+
+    // Fisher-Yates shuffle, drawing random words a block at a time
+    template <class RandomIt>
+    void shuffle(RandomIt first, RandomIt last)
+    {
+        const size_t BLOCK = 64;
+        uint64_t words[BLOCK];
+        size_t n = static_cast<size_t>(last - first);
+        size_t used = BLOCK;
+        for (size_t i = n; i > 1; i--)
+        {
+            if (used == BLOCK)
+            {
+                fill(words, BLOCK);
+                used = 0;
+            }
+            size_t j = bounded(words[used++], static_cast<uint32_t>(i));
+            std::swap(first[i - 1], first[j]);
+        }
+    }
+
+    // splitmix64 finalizer; also useful for deriving per-game seeds
+    static uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // A seed taken from the operating system's entropy source
+    static uint64_t randomSeed()
+    {
+        std::random_device rd;
+        return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    // Lemire's multiply-shift reduction of a 32-bit draw, rejecting the
+    // few values that would bias the result
+    int bounded(uint64_t word, uint32_t limit)
+    {
+        uint64_t m = (word >> 32) * limit;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < limit)
+        {
+            uint32_t threshold = (0u - limit) % limit;
+            while (low < threshold)
+            {
+                m = (next() >> 32) * limit;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<int>(m >> 32);
+    }
+
+    uint64_t s[4];
+};
 
 #endif // GLOBALS_INCLUDED
@@ -1,5 +1,10 @@
+#include "Board.h"
+#include "FrameRenderer.h"
 #include "Game.h"
+#include "GameEvents.h"
 #include "Player.h"
+#include "Profiler.h"
+#include <fstream>
 #include <iostream>
 #include <string>
 
@@ -14,9 +19,11 @@ bool addStandardShips(Game& g)
         g.addShip(2, 'P', "patrol boat");
 }
 
-int main()
+// An optional argument names a file to write call latencies to as JSON
+int main(int argc, char* argv[])
 {
     const int NTRIALS = 10;
+    Profiler::enable(argc > 1);
 
     cout << "Select one of these choices for an example of the game:" << endl;
     cout << "  1.  A mini-game between two mediocre players" << endl;
@@ -24,6 +31,7 @@ int main()
     cout << "  3.  A " << NTRIALS
         << "-game match between a mediocre and an awful player, with no pauses"
         << endl;
+    cout << "  4.  A game between two good players, redrawn in place" << endl;
     cout << "Enter your choice: ";
     string line;
     getline(cin, line);
@@ -57,31 +65,55 @@ int main()
     {
         int nMediocreWins = 0;
 
+        // One set of players and boards, reset between games
+        Game g(10, 10);
+        addStandardShips(g);
+        Player* p1 = createPlayer("good", "Good Gary", g);
+        Player* p2 = createPlayer("mediocre", "Mediocre Mimi", g);
+        Board b1(g);
+        Board b2(g);
+        ConsoleEventSink sink(g, false);
         for (int k = 1; k <= NTRIALS; k++)
         {
             cout << "============================= Game " << k
                 << " =============================" << endl;
-            Game g(10, 10);
-            addStandardShips(g);
-            Player* p1 = createPlayer("good", "Good Gary", g);
-            Player* p2 = createPlayer("mediocre", "Mediocre Mimi", g);
+            p1->reset();
+            p2->reset();
             Player* winner = (k % 2 == 1 ?
-                g.play(p1, p2, false) : g.play(p2, p1, false));
+                g.play(p1, p2, b1, b2, sink) : g.play(p2, p1, b2, b1, sink));
             if (winner == p2)
                 nMediocreWins++;
-            delete p1;
-            delete p2;
         }
+        delete p1;
+        delete p2;
         cout << "The mediocre player won " << nMediocreWins << " out of "
             << NTRIALS << " games." << endl;
         // We'd expect a mediocre player to win most of the games against
         // an awful player.  Similarly, a good player should outperform
         // a mediocre player.
     }
+    else if (line[0] == '4')
+    {
+        // Needs a terminal that understands ANSI cursor movement
+        Game g(10, 10);
+        addStandardShips(g);
+        Player* p1 = createPlayer("good", "Good Gary", g);
+        Player* p2 = createPlayer("good", "Good Greta", g);
+        FrameEventSink sink(g, FrameRenderer::ANSI, 60);
+        g.play(p1, p2, sink);
+        delete p1;
+        delete p2;
+    }
     else
     {
         cout << "That's not one of the choices." << endl;
     }
+
+    if (argc > 1)
+    {
+        ofstream out(argv[1]);
+        Profiler::writeJson(out);
+    }
 }
 
 
@@ -0,0 +1,340 @@
+// Replays a record file written by tournament -w and checks that the
+// players still make exactly the recorded games.
+//
+//   replay <recordfile> [-t threads] [-b bookfile]
+//
+// Every game is played again from its recorded seed by players of the
+// recorded types, reset before each game as tournament does.  Each
+// placement and shot is compared with the record, and the first point
+// where a game differs is reported, so a change to the board or the
+// players can be checked against a large body of games recorded before
+// it.  Games are replayed in parallel; the report names the lowest-numbered
+// game that diverged.  The exit status is 0 only if every game matched.
+// Games played with an opening book must be replayed with the same book.
+//
+// e.g.  tournament good mediocre -n 1000000 -s 1 -w before.rec
+//       replay before.rec
+
+#include "Board.h"
+#include "Game.h"
+#include "GameEvents.h"
+#include "GameRecord.h"
+#include "OpeningBook.h"
+#include "Player.h"
+#include "ToolSupport.h"
+#include "globals.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+typedef GameRecordReader::Record Record;
+
+struct Divergence
+{
+    uint32_t game = UINT32_MAX;             // UINT32_MAX if no game diverged
+    uint64_t seed = 0;
+    string what;
+};
+
+// Compares a game being replayed against its record, event by event
+class ReplayChecker final : public GameEventSink
+{
+public:
+    ReplayChecker(const GameRecordReader& file, const Game& g)
+        : m_file(file), m_game(g), m_record(nullptr), m_shot(0)
+    {}
+
+    void startGame(const Record& rec)
+    {
+        m_record = &rec;
+        m_shot = 0;
+        m_what.clear();
+    }
+
+    // Returns false, and describes the first difference in what(), if the
+    // game just played differs from its record
+    bool endGame(const Board& side0, const Board& side1, int winnerSide);
+    const string& what() const { return m_what; }
+
+    void placementStarted(const Player&, int) override {}
+    void turnStarted(const Player&, const Player&, const Board&) override {}
+    void shotWasted(const Player&, Point p) override { check(p, SHOT_WASTED); }
+    void shotFired(const Player&, const Board&, Point p, bool shotHit, bool shipDestroyed, int) override
+    {
+        check(p, !shotHit ? SHOT_MISS : (shipDestroyed ? SHOT_SUNK : SHOT_HIT));
+    }
+    void shipSunk(const Player&, int) override {}
+    void gameWon(const Player&, const Board&) override {}
+    void turnEnded(const Player&) override {}
+
+private:
+    void check(Point p, ShotResult result);
+    string describeCell(uint32_t cell) const;
+
+    const GameRecordReader& m_file;
+    const Game& m_game;
+    const Record* m_record;
+    int m_shot;                             // shots replayed so far
+    string m_what;                          // first difference, if any
+};
+
+static const char* const RESULT_NAMES[] = { "miss", "hit", "sunk", "wasted" };
+
+string ReplayChecker::describeCell(uint32_t cell) const
+{
+    if (cell == m_file.noCell())
+        return "off the board";
+    ostringstream out;
+    out << '(' << cell / m_game.cols() << ',' << cell % m_game.cols() << ')';
+    return out.str();
+}
+
+void ReplayChecker::check(Point p, ShotResult result)
+{
+    // Only the first difference matters; later ones follow from it
+    if (!m_what.empty())
+        return;
+    uint32_t cell = (m_game.isValid(p) ? p.r * m_game.cols() + p.c : m_file.noCell());
+    int k = m_shot++;
+    if (k < m_record->nShots() && cell == m_record->shotCell(k) && result == m_record->shotResult(k))
+        return;
+
+    ostringstream out;
+    if (k >= m_record->nShots())
+        out << "shot " << k << ": replay went on after the recorded game ended";
+    else
+        out << "shot " << k << " by side " << m_record->attacker(k)
+            << ": recorded " << describeCell(m_record->shotCell(k))
+            << ' ' << RESULT_NAMES[m_record->shotResult(k)]
+            << ", replayed " << describeCell(cell) << ' ' << RESULT_NAMES[result];
+    m_what = out.str();
+}
+
+bool ReplayChecker::endGame(const Board& side0, const Board& side1, int winnerSide)
+{
+    // Ships are placed before any shot, so a placement difference comes first
+    const Board* boards[2] = { &side0, &side1 };
+    for (int side = 0; side < 2; side++)
+    {
+        for (int shipId = 0; shipId < m_game.nShips(); shipId++)
+        {
+            Point was, now;
+            Direction wasDir = HORIZONTAL, nowDir = HORIZONTAL;
+            bool wasPlaced = m_record->placement(side, shipId, was, wasDir);
+            bool nowPlaced = boards[side]->shipPlacement(shipId, now, nowDir);
+            if (wasPlaced != nowPlaced ||
+                (wasPlaced && (was.r != now.r || was.c != now.c || wasDir != nowDir)))
+            {
+                ostringstream out;
+                out << "placement of ship " << shipId << " by side " << side << " differs";
+                m_what = out.str();
+                return false;
+            }
+        }
+    }
+    if (!m_what.empty())
+        return false;
+
+    if (m_shot == m_record->nShots() && winnerSide == m_record->winner())
+        return true;
+
+    ostringstream out;
+    if (m_shot < m_record->nShots())
+        out << "replay ended after " << m_shot << " shots, record has " << m_record->nShots();
+    else
+        out << "recorded winner " << m_record->winner() << ", replayed " << winnerSide;
+    m_what = out.str();
+    return false;
+}
+
+//******************** Driver *****************************************
+
+// Hands out records to the workers a batch at a time
+class RecordQueue
+{
+public:
+    explicit RecordQueue(const GameRecordReader& file)
+        : m_next(file.begin()), m_end(file.end())
+    {}
+
+    // Fills batch with up to n records; false once none are left
+    bool take(vector<Record>& batch, size_t n)
+    {
+        batch.clear();
+        lock_guard<mutex> lock(m_mutex);
+        for ( ; batch.size() < n && m_next != m_end; ++m_next)
+            batch.push_back(*m_next);
+        return !batch.empty();
+    }
+
+private:
+    mutex m_mutex;
+    GameRecordReader::const_iterator m_next;
+    GameRecordReader::const_iterator m_end;
+};
+
+struct ReplayResult
+{
+    long long nGames = 0;
+    long long nDiverged = 0;
+    Divergence first;                       // lowest-numbered game that diverged
+};
+
+// Replay games from the queue until it runs dry, accumulating into a local result
+static void runWorker(const GameRecordReader& file, const OpeningBook* book, RecordQueue& queue,
+    ReplayResult& total, mutex& totalMutex)
+{
+    const GameRecordInfo& info = file.info();
+    ReplayResult local;
+    Game g(info.rows, info.cols, 0);
+    addFleet(g, info.fleet);
+    g.setOpeningBook(book);
+
+    // The same players and boards, reset for every game, just as tournament plays them
+    Player* p0 = createPlayer(info.type[0], info.type[0] + " 0", g);
+    Player* p1 = createPlayer(info.type[1], info.type[1] + " 1", g);
+    Board b0(g);
+    Board b1(g);
+    ReplayChecker checker(file, g);
+
+    vector<Record> batch;
+    while (queue.take(batch, 64))
+    {
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            const Record& rec = batch[i];
+            g.reseed(rec.seed());
+            p0->reset();
+            p1->reset();
+            checker.startGame(rec);
+            Player* winner = (rec.firstSide() == 0 ?
+                g.play(p0, p1, b0, b1, checker) : g.play(p1, p0, b1, b0, checker));
+            local.nGames++;
+            if (!checker.endGame(b0, b1, winner == p0 ? 0 : (winner == p1 ? 1 : -1)))
+            {
+                local.nDiverged++;
+                if (rec.game() < local.first.game)
+                {
+                    local.first.game = rec.game();
+                    local.first.seed = rec.seed();
+                    local.first.what = checker.what();
+                }
+            }
+        }
+    }
+    delete p0;
+    delete p1;
+
+    lock_guard<mutex> lock(totalMutex);
+    total.nGames += local.nGames;
+    total.nDiverged += local.nDiverged;
+    if (local.first.game < total.first.game)
+        total.first = local.first;
+}
+
+static void usage()
+{
+    cerr << "Usage: replay <recordfile> [-t threads] [-b bookfile]" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        usage();
+        return 2;
+    }
+    string path = argv[1];
+    int nThreads = 0;
+    string bookPath;
+    for (int i = 2; i < argc; i += 2)
+    {
+        string opt = argv[i];
+        bool ok = (i + 1 < argc);
+        if (ok && opt == "-t")
+            ok = (nThreads = atoi(argv[i + 1])) >= 0;
+        else if (ok && opt == "-b")
+            bookPath = argv[i + 1];
+        else
+            ok = false;
+        if (!ok)
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    GameRecordReader file(path);
+    if (!file.isOpen())
+    {
+        cerr << "Cannot read " << path << " as a game record file" << endl;
+        return 2;
+    }
+    const GameRecordInfo& info = file.info();
+
+    // Validate the recorded configuration before starting any threads
+    unique_ptr<OpeningBook> book;
+    if (!bookPath.empty())
+        book.reset(new OpeningBook(bookPath));
+    {
+        Game g(info.rows, info.cols);
+        if (!addFleet(g, info.fleet))
+            return 2;
+        if (book && !(book->isOpen() && g.setOpeningBook(book.get())))
+        {
+            cerr << bookPath << " is not an opening book for the recorded board and fleet" << endl;
+            return 2;
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            Player* p = createPlayer(info.type[i], "check", g);
+            bool ok = (p != nullptr && !p->isHuman());
+            delete p;
+            if (!ok)
+            {
+                cerr << "Unknown or non-AI player type " << info.type[i] << endl;
+                return 2;
+            }
+        }
+    }
+
+    if (nThreads == 0)
+        nThreads = max(1u, thread::hardware_concurrency());
+
+    RecordQueue queue(file);
+    ReplayResult result;
+    mutex resultMutex;
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < nThreads; t++)
+        workers.emplace_back(runWorker, cref(file), book.get(), ref(queue), ref(result), ref(resultMutex));
+    for (size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%lld games replayed, %s vs %s, %dx%d board, %d ships, %d threads\n",
+        result.nGames, info.type[0].c_str(), info.type[1].c_str(), info.rows, info.cols,
+        static_cast<int>(info.fleet.size()), nThreads);
+    printf("  %.3f s, %.1f games/s\n", seconds, result.nGames / seconds);
+    if (result.nDiverged == 0)
+    {
+        printf("  every game matched its record\n");
+        return 0;
+    }
+    printf("  %lld games diverged; first is game %u (seed %llu): %s\n",
+        result.nDiverged, result.first.game,
+        static_cast<unsigned long long>(result.first.seed), result.first.what.c_str());
+    return 1;
+}
@@ -0,0 +1,384 @@
+// Round-robin cross-evaluation of computer players.
+//
+// Every competitor plays every competitor, itself included, and the results
+// are written as one CSV row per ordered pair.  By default a competitor is
+// every combination of one type's ship placement with another type's
+// targeting ("good/montecarlo" places like good and attacks like
+// montecarlo), so the matrix shows whether placement or targeting decides
+// the games.
+//
+//   roundrobin [-p types] [-x 0|1] [-n games per pair] [-t threads]
+//              [-r rows] [-c cols] [-f lengths] [-s seed] [-o file]
+//
+// In each pair the first competitor moves first in every game.  Game k of
+// pair i is seeded with Rng::mix(seed + i * games + k).  Workers claim a few
+// games at a time from one counter over all pairs, so pairs with slow
+// players are spread over every thread instead of holding up one.
+//
+// e.g.  roundrobin -p awful,mediocre,good -n 2000 -o matrix.csv
+
+#include "Board.h"
+#include "Game.h"
+#include "GameEvents.h"
+#include "Player.h"
+#include "ToolSupport.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct RoundRobinConfig
+{
+    vector<string> types = aiPlayerTypes();
+    bool split = true;                      // pair every placement with every targeting
+    int nGames = 200;                       // games per ordered pair
+    int nThreads = 0;                       // 0 means one per hardware thread
+    int rows = 10;
+    int cols = 10;
+    vector<int> fleet = { 5, 4, 3, 3, 2 };
+    uint64_t seed = 1;
+    string output;                          // CSV file, or standard output if empty
+};
+
+// Results of one ordered pair; side 0 is the competitor that moves first
+struct PairResult
+{
+    int wins[2] = { 0, 0 };
+    int failures = 0;                       // games where ships could not be placed
+    vector<int> shotsToWin[2];              // shots the winner took, per game won
+};
+
+struct Competitor
+{
+    string placement;
+    string targeting;
+    string type;                            // as given to createPlayer
+};
+
+// Games are claimed this many at a time
+const int CHUNK = 8;
+
+static void usage()
+{
+    cerr << "Usage: roundrobin [-p types] [-x 0|1] [-n games per pair] [-t threads]" << endl
+        << "                  [-r rows] [-c cols] [-f lengths] [-s seed] [-o file]" << endl
+        << "  -p takes comma-separated player types (default every computer player)" << endl
+        << "  -x 0 pits the types against each other without splitting placement from targeting" << endl
+        << "  -f takes comma-separated ship lengths (default 5,4,3,3,2)" << endl;
+}
+
+static bool parseList(const string& text, vector<string>& items)
+{
+    items.clear();
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ','))
+    {
+        if (item.empty())
+            return false;
+        items.push_back(item);
+    }
+    return !items.empty();
+}
+
+static bool parseArgs(int argc, char* argv[], RoundRobinConfig& cfg)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string opt = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        string val = argv[++i];
+        if (opt == "-p")
+        {
+            if (!parseList(val, cfg.types))
+                return false;
+        }
+        else if (opt == "-x")
+            cfg.split = atoi(val.c_str()) != 0;
+        else if (opt == "-n")
+            cfg.nGames = atoi(val.c_str());
+        else if (opt == "-t")
+            cfg.nThreads = atoi(val.c_str());
+        else if (opt == "-r")
+            cfg.rows = atoi(val.c_str());
+        else if (opt == "-c")
+            cfg.cols = atoi(val.c_str());
+        else if (opt == "-s")
+            cfg.seed = strtoull(val.c_str(), nullptr, 0);
+        else if (opt == "-o")
+            cfg.output = val;
+        else if (opt == "-f")
+        {
+            if (!parseFleet(val, cfg.fleet))
+                return false;
+        }
+        else
+            return false;
+    }
+    return cfg.nGames > 0 && cfg.nThreads >= 0;
+}
+
+static void merge(PairResult& total, const PairResult& local, mutex& totalMutex)
+{
+    lock_guard<mutex> lock(totalMutex);
+    for (int i = 0; i < 2; i++)
+    {
+        total.wins[i] += local.wins[i];
+        total.shotsToWin[i].insert(total.shotsToWin[i].end(),
+            local.shotsToWin[i].begin(), local.shotsToWin[i].end());
+    }
+    total.failures += local.failures;
+}
+
+// Play chunks of games until every pair is done.  A worker keeps the players
+// of the pair it is on and only builds new ones when it moves to another.
+static void runWorker(const RoundRobinConfig& cfg, const vector<Competitor>& competitors,
+    atomic<long long>& nextGame, vector<PairResult>& results, mutex& resultMutex)
+{
+    NullEventSink quiet;
+    Game g(cfg.rows, cfg.cols, cfg.seed);
+    addFleet(g, cfg.fleet);
+    Board b0(g);
+    Board b1(g);
+    unique_ptr<CountingPlayer> p0, p1;
+    long long current = -1;                 // pair the players were built for
+
+    size_t n = competitors.size();
+    long long nPairs = static_cast<long long>(n * n);
+    long long total = nPairs * cfg.nGames;
+    PairResult local;
+    for (long long first = nextGame.fetch_add(CHUNK); first < total; first = nextGame.fetch_add(CHUNK))
+    {
+        long long last = min(total, first + CHUNK);
+        for (long long game = first; game < last; game++)
+        {
+            long long pair = game / cfg.nGames;
+            if (pair != current)
+            {
+                if (current >= 0)
+                    merge(results[current], local, resultMutex);
+                local = PairResult();
+                const Competitor& a = competitors[pair / n];
+                const Competitor& b = competitors[pair % n];
+                p0.reset(new CountingPlayer(createPlayer(a.type, a.type + " 0", g), g));
+                p1.reset(new CountingPlayer(createPlayer(b.type, b.type + " 1", g), g));
+                current = pair;
+            }
+
+            g.reseed(Rng::mix(cfg.seed + game));
+            p0->reset();
+            p1->reset();
+            Player* winner = g.play(p0.get(), p1.get(), b0, b1, quiet);
+            if (winner == p0.get())
+            {
+                local.wins[0]++;
+                local.shotsToWin[0].push_back(p0->shots());
+            }
+            else if (winner == p1.get())
+            {
+                local.wins[1]++;
+                local.shotsToWin[1].push_back(p1->shots());
+            }
+            else
+                local.failures++;
+        }
+    }
+
+    if (current >= 0)
+        merge(results[current], local, resultMutex);
+}
+
+// Summary of a shot count distribution
+struct ShotStats
+{
+    double mean = 0;
+    double stddev = 0;
+    int min = 0, p10 = 0, median = 0, p90 = 0, max = 0;
+};
+
+static ShotStats shotStats(vector<int> v)
+{
+    ShotStats s;
+    if (v.empty())
+        return s;
+    sort(v.begin(), v.end());
+    double sum = 0;
+    for (size_t i = 0; i < v.size(); i++)
+        sum += v[i];
+    s.mean = sum / v.size();
+    double sq = 0;
+    for (size_t i = 0; i < v.size(); i++)
+        sq += (v[i] - s.mean) * (v[i] - s.mean);
+    s.stddev = sqrt(sq / v.size());
+    s.min = v.front();
+    s.p10 = v[(v.size() - 1) / 10];
+    s.median = v[(v.size() - 1) / 2];
+    s.p90 = v[(v.size() - 1) * 9 / 10];
+    s.max = v.back();
+    return s;
+}
+
+static void writeCsv(ostream& out, const RoundRobinConfig& cfg, const vector<Competitor>& competitors,
+    const vector<PairResult>& results)
+{
+    out << "first_placement,first_targeting,second_placement,second_targeting,games,failures";
+    const char* sides[2] = { "first", "second" };
+    for (int i = 0; i < 2; i++)
+        out << ',' << sides[i] << "_wins," << sides[i] << "_win_rate,"
+            << sides[i] << "_shots_mean," << sides[i] << "_shots_stddev,"
+            << sides[i] << "_shots_min," << sides[i] << "_shots_p10,"
+            << sides[i] << "_shots_median," << sides[i] << "_shots_p90,"
+            << sides[i] << "_shots_max";
+    out << '\n';
+
+    size_t n = competitors.size();
+    char buf[64];
+    for (size_t pair = 0; pair < results.size(); pair++)
+    {
+        const Competitor& a = competitors[pair / n];
+        const Competitor& b = competitors[pair % n];
+        const PairResult& r = results[pair];
+        out << a.placement << ',' << a.targeting << ',' << b.placement << ',' << b.targeting
+            << ',' << cfg.nGames << ',' << r.failures;
+        for (int i = 0; i < 2; i++)
+        {
+            ShotStats s = shotStats(r.shotsToWin[i]);
+            snprintf(buf, sizeof(buf), "%.4f,%.2f,%.2f", static_cast<double>(r.wins[i]) / cfg.nGames,
+                s.mean, s.stddev);
+            out << ',' << r.wins[i] << ',' << buf << ',' << s.min << ',' << s.p10 << ','
+                << s.median << ',' << s.p90 << ',' << s.max;
+        }
+        out << '\n';
+    }
+}
+
+// Win rate of each placement and each targeting over every game it played,
+// on either side
+static void printSummary(const RoundRobinConfig& cfg, const vector<Competitor>& competitors,
+    const vector<PairResult>& results)
+{
+    size_t nTypes = cfg.types.size();
+    vector<long long> placeWins(nTypes, 0), placeGames(nTypes, 0);
+    vector<long long> targetWins(nTypes, 0), targetGames(nTypes, 0);
+    size_t n = competitors.size();
+    for (size_t pair = 0; pair < results.size(); pair++)
+    {
+        size_t side[2] = { pair / n, pair % n };
+        for (int i = 0; i < 2; i++)
+        {
+            // Competitors are numbered placement-major when split
+            size_t place = cfg.split ? side[i] / nTypes : side[i];
+            size_t target = cfg.split ? side[i] % nTypes : side[i];
+            placeWins[place] += results[pair].wins[i];
+            placeGames[place] += cfg.nGames;
+            targetWins[target] += results[pair].wins[i];
+            targetGames[target] += cfg.nGames;
+        }
+    }
+
+    fprintf(stderr, "  %-24s %10s %10s\n", "type", "placement", "targeting");
+    for (size_t t = 0; t < nTypes; t++)
+        fprintf(stderr, "  %-24s %9.2f%% %9.2f%%\n", cfg.types[t].c_str(),
+            100.0 * placeWins[t] / placeGames[t], 100.0 * targetWins[t] / targetGames[t]);
+}
+
+int main(int argc, char* argv[])
+{
+    RoundRobinConfig cfg;
+    if (!parseArgs(argc, argv, cfg))
+    {
+        usage();
+        return 1;
+    }
+
+    if (cfg.rows < 1 || cfg.rows > MAXROWS || cfg.cols < 1 || cfg.cols > MAXCOLS)
+    {
+        cerr << "Board must be between 1x1 and " << MAXROWS << 'x' << MAXCOLS << endl;
+        return 1;
+    }
+
+    // Validate the configuration once before starting any threads
+    {
+        Game g(cfg.rows, cfg.cols);
+        if (!addFleet(g, cfg.fleet))
+            return 1;
+        for (size_t i = 0; i < cfg.types.size(); i++)
+        {
+            Player* p = createPlayer(cfg.types[i], "check", g);
+            bool ok = (p != nullptr && !p->isHuman() && cfg.types[i].find('/') == string::npos);
+            delete p;
+            if (!ok)
+            {
+                cerr << "Unknown or non-AI player type " << cfg.types[i] << endl;
+                return 1;
+            }
+        }
+    }
+
+    vector<Competitor> competitors;
+    for (size_t i = 0; i < cfg.types.size(); i++)
+    {
+        if (!cfg.split)
+        {
+            competitors.push_back(Competitor{ cfg.types[i], cfg.types[i], cfg.types[i] });
+            continue;
+        }
+        for (size_t j = 0; j < cfg.types.size(); j++)
+            competitors.push_back(Competitor{ cfg.types[i], cfg.types[j],
+                i == j ? cfg.types[i] : cfg.types[i] + "/" + cfg.types[j] });
+    }
+    size_t nPairs = competitors.size() * competitors.size();
+
+    int nThreads = cfg.nThreads;
+    if (nThreads == 0)
+        nThreads = max(1u, thread::hardware_concurrency());
+    long long nChunks = (static_cast<long long>(nPairs) * cfg.nGames + CHUNK - 1) / CHUNK;
+    nThreads = static_cast<int>(min<long long>(nThreads, nChunks));
+
+    vector<PairResult> results(nPairs);
+    mutex resultMutex;
+    atomic<long long> nextGame(0);
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < nThreads; t++)
+        workers.emplace_back(runWorker, cref(cfg), cref(competitors), ref(nextGame), ref(results), ref(resultMutex));
+    for (size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (cfg.output.empty())
+        writeCsv(cout, cfg, competitors, results);
+    else
+    {
+        ofstream out(cfg.output);
+        writeCsv(out, cfg, competitors, results);
+        if (!out)
+        {
+            cerr << "Cannot write " << cfg.output << endl;
+            return 1;
+        }
+    }
+
+    long long nGames = static_cast<long long>(nPairs) * cfg.nGames;
+    fprintf(stderr, "%zu competitors, %zu pairs, %lld games, %d threads, %dx%d board, %d ships, seed %llu\n",
+        competitors.size(), nPairs, nGames, nThreads, cfg.rows, cfg.cols,
+        static_cast<int>(cfg.fleet.size()), static_cast<unsigned long long>(cfg.seed));
+    printSummary(cfg, competitors, results);
+    fprintf(stderr, "  %.3f s, %.1f games/s\n", seconds, nGames / seconds);
+    return 0;
+}
@@ -0,0 +1,712 @@
+// Headless AI-vs-AI tournament runner.
+//
+// Plays many games between two computer players in parallel and reports
+// win rates, shots needed to win and throughput.  Nothing is printed while
+// the games run.
+//
+//   tournament <player1> <player2> [-n games] [-t threads]
+//              [-r rows] [-c cols] [-f lengths] [-s seed] [-a 0|1]
+//              [-w recordfile] [-b bookfile] [-j profile.json] [-l 0|1|2]
+//              [-d ms] [-y games]
+//
+// Game k is seeded with Rng::mix(seed + k), so any single game can be
+// re-run by constructing a Game with that seed.  -w also saves every game
+// to a binary record file (see GameRecord.h).  -b lets the players take
+// their early shots from an opening book written by the book tool (see
+// OpeningBook.h); replaying games played with a book needs the same book.
+// -j profiles every player and board call and each phase of every game,
+// and writes the latency histograms as JSON (see Profiler.h).  -l 1 plays
+// the games in lockstep batches (see Lockstep.h), for players such as awful
+// and heat whose shots the engine can work out itself; the results are the
+// same, only faster.  -l 2 also plays every game the usual way and checks
+// that the two agree.  -d makes every shot arrive that many milliseconds
+// after it is asked for, like a bot answering over the network.  -y plays
+// up to that many games at once as resumable games (see GameScheduler.h),
+// so the threads play whichever games have a shot ready instead of
+// sleeping through each delay.
+//
+// Each worker thread builds one pair of players and boards from its own
+// arena and resets them in place for every game it plays, so the workers
+// stay off the heap once they are running.  Working memory the players
+// need only while placing ships comes from a per-thread pool instead (see
+// PlacementSolver::Scratch), since an arena never takes memory back.  -a 0
+// allocates the players and boards from the heap, for comparison.
+//
+// e.g.  tournament good mediocre -n 100000 -f 5,4,3,3,2
+
+#include "Arena.h"
+#include "Board.h"
+#include "Game.h"
+#include "GameEvents.h"
+#include "GameRecord.h"
+#include "GameScheduler.h"
+#include "Lockstep.h"
+#include "OpeningBook.h"
+#include "Player.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include "ToolSupport.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct TournamentConfig
+{
+    string type[2];
+    int nGames = 1000;
+    int nThreads = 0;                       // 0 means one per hardware thread
+    int rows = 10;
+    int cols = 10;
+    vector<int> fleet = { 5, 4, 3, 3, 2 };
+    uint64_t seed = Rng::randomSeed();      // base seed for the whole tournament
+    bool useArena = true;                   // allocate players and boards from a per-thread arena
+    string recordPath;                      // file to save every game to, if any
+    string bookPath;                        // opening book for the players, if any
+    string profilePath;                     // file to write call latencies to, if any
+    int lockstep = 0;                       // 1 to play in lockstep, 2 to check it too
+    int delayMs = 0;                        // before each shot arrives
+    int inFlight = 0;                       // games played at once as resumable games, or 0
+};
+
+struct TournamentResult
+{
+    int wins[2] = { 0, 0 };                 // games won by each player type
+    int failures = 0;                       // games where ships could not be placed
+    vector<int> shotsToWin[2];              // shots the winner took, per game won
+    int mismatches = 0;                     // lockstep games the usual way played differently
+    int firstMismatch = INT_MAX;            // lowest-numbered such game
+};
+
+// Calls functions at set times, all from one thread
+class ReplyTimer
+{
+public:
+    ReplyTimer() : m_stopping(false), m_thread(&ReplyTimer::runLoop, this) {}
+
+    ~ReplyTimer()
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_changed.notify_one();
+        m_thread.join();
+    }
+
+    void after(int ms, const function<void()>& fn)
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_due.push(Call{ chrono::steady_clock::now() + chrono::milliseconds(ms), fn });
+        }
+        m_changed.notify_one();
+    }
+
+private:
+    struct Call
+    {
+        chrono::steady_clock::time_point at;
+        function<void()> fn;
+        bool operator<(const Call& other) const { return at > other.at; }   // earliest on top
+    };
+
+    void runLoop()
+    {
+        unique_lock<mutex> lock(m_mutex);
+        while (!m_stopping)
+        {
+            if (m_due.empty())
+                m_changed.wait(lock);
+            else if (m_due.top().at > chrono::steady_clock::now())
+            {
+                // A copy: after can move the queue's storage while this waits
+                chrono::steady_clock::time_point at = m_due.top().at;
+                m_changed.wait_until(lock, at);
+            }
+            else
+            {
+                function<void()> fn = m_due.top().fn;
+                m_due.pop();
+                lock.unlock();
+                fn();
+                lock.lock();
+            }
+        }
+    }
+
+    mutex m_mutex;
+    condition_variable m_changed;
+    priority_queue<Call> m_due;
+    bool m_stopping;
+    thread m_thread;
+};
+
+// Wraps a player so that each shot arrives delayMs after it is asked for,
+// like a bot answering over the network.  recommendAttack sleeps through
+// the delay; tryAttack has timer wake the game instead.  Everything else
+// is forwarded.
+class LaggedPlayer : public Player
+{
+public:
+    LaggedPlayer(Player* inner, const Game& g, int delayMs, ReplyTimer* timer)
+        : Player(inner->name(), g), m_inner(inner), m_delayMs(delayMs), m_timer(timer),
+          m_asked(false), m_arrived(false)
+    {}
+    ~LaggedPlayer() { delete m_inner; }
+
+    virtual bool placeShips(Board& b) { return m_inner->placeShips(b); }
+    virtual Point recommendAttack()
+    {
+        this_thread::sleep_for(chrono::milliseconds(m_delayMs));
+        return m_inner->recommendAttack();
+    }
+    virtual bool tryAttack(Point& p, const function<void()>& ready)
+    {
+        if (!m_asked)
+        {
+            m_shot = m_inner->recommendAttack();
+            m_asked = true;
+            m_timer->after(m_delayMs, [this, ready] {
+                m_arrived = true;
+                ready();
+            });
+        }
+        if (!m_arrived)
+            return false;
+        m_asked = false;
+        m_arrived = false;
+        p = m_shot;
+        return true;
+    }
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+        bool shipDestroyed, int shipId)
+    {
+        m_inner->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+    }
+    virtual void recordAttackByOpponent(Point p) { m_inner->recordAttackByOpponent(p); }
+    virtual void reset()
+    {
+        m_asked = false;
+        m_arrived = false;
+        m_inner->reset();
+    }
+
+private:
+    Player* m_inner;
+    int m_delayMs;
+    ReplyTimer* m_timer;
+    Point m_shot;                           // the shot on its way
+    bool m_asked;                           // m_shot is on its way
+    atomic<bool> m_arrived;                 // m_shot has arrived
+};
+
+static void usage()
+{
+    cerr << "Usage: tournament <player1> <player2> [-n games] [-t threads]" << endl
+        << "                  [-r rows] [-c cols] [-f lengths] [-s seed] [-a 0|1]" << endl
+        << "                  [-w recordfile] [-b bookfile] [-j profile.json] [-l 0|1|2]" << endl
+        << "                  [-d ms] [-y games]" << endl
+        << "  player types: awful, mediocre, good, montecarlo[:samples[:threads]]," << endl
+        << "                mcts[:iterations[:ms[:threads]]], heat" << endl
+        << "  -f takes comma-separated ship lengths (default 5,4,3,3,2)" << endl;
+}
+
+static bool parseArgs(int argc, char* argv[], TournamentConfig& cfg)
+{
+    if (argc < 3)
+        return false;
+    cfg.type[0] = argv[1];
+    cfg.type[1] = argv[2];
+
+    for (int i = 3; i < argc; i++)
+    {
+        string opt = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        string val = argv[++i];
+        if (opt == "-n")
+            cfg.nGames = atoi(val.c_str());
+        else if (opt == "-t")
+            cfg.nThreads = atoi(val.c_str());
+        else if (opt == "-r")
+            cfg.rows = atoi(val.c_str());
+        else if (opt == "-c")
+            cfg.cols = atoi(val.c_str());
+        else if (opt == "-s")
+            cfg.seed = strtoull(val.c_str(), nullptr, 0);
+        else if (opt == "-a")
+            cfg.useArena = atoi(val.c_str()) != 0;
+        else if (opt == "-w")
+            cfg.recordPath = val;
+        else if (opt == "-b")
+            cfg.bookPath = val;
+        else if (opt == "-j")
+            cfg.profilePath = val;
+        else if (opt == "-l")
+            cfg.lockstep = atoi(val.c_str());
+        else if (opt == "-d")
+            cfg.delayMs = atoi(val.c_str());
+        else if (opt == "-y")
+            cfg.inFlight = atoi(val.c_str());
+        else if (opt == "-f")
+        {
+            if (!parseFleet(val, cfg.fleet))
+                return false;
+        }
+        else
+            return false;
+    }
+    return cfg.nGames > 0 && cfg.nThreads >= 0 && cfg.lockstep >= 0 && cfg.lockstep <= 2 &&
+        cfg.delayMs >= 0 && cfg.inFlight >= 0;
+}
+
+// Player i of the tournament, slowed down by -d.  Shots asked for with
+// tryAttack are delivered by timer.
+static Player* createTournamentPlayer(const TournamentConfig& cfg, int i, const Game& g, ReplyTimer* timer)
+{
+    Player* p = createPlayer(cfg.type[i], cfg.type[i] + ' ' + to_string(i), g);
+    if (cfg.delayMs > 0)
+        p = new LaggedPlayer(p, g, cfg.delayMs, timer);
+    return p;
+}
+
+// Play game k, player k % 2 moving first.  Return the index of the winner,
+// or -1 if the ships could not be placed, and set shots to the shots the
+// winner took.
+static int playGame(const TournamentConfig& cfg, Game& g, CountingPlayer& p0, CountingPlayer& p1,
+    Board& b0, Board& b1, int k, GameRecorder* recorder, int& shots)
+{
+    NullEventSink quiet;
+    g.reseed(Rng::mix(cfg.seed + k));
+    p0.reset();
+    p1.reset();
+
+    // Alternate who moves first
+    Player* winner;
+    if (recorder != nullptr)
+    {
+        recorder->startGame(k, k % 2);
+        winner = (k % 2 == 0 ?
+            g.play(&p0, &p1, b0, b1, *recorder) : g.play(&p1, &p0, b1, b0, *recorder));
+        recorder->endGame(b0, b1, winner == &p0 ? 0 : (winner == &p1 ? 1 : -1));
+    }
+    else
+        winner = (k % 2 == 0 ?
+            g.play(&p0, &p1, b0, b1, quiet) : g.play(&p1, &p0, b1, b0, quiet));
+
+    shots = (winner == &p0 ? p0.shots() : winner == &p1 ? p1.shots() : 0);
+    return winner == &p0 ? 0 : (winner == &p1 ? 1 : -1);
+}
+
+static void addGame(TournamentResult& result, int winner, int shots)
+{
+    if (winner >= 0)
+    {
+        result.wins[winner]++;
+        result.shotsToWin[winner].push_back(shots);
+    }
+    else
+        result.failures++;
+}
+
+static void mergeResult(const TournamentResult& local, TournamentResult& total, mutex& totalMutex)
+{
+    lock_guard<mutex> lock(totalMutex);
+    for (int i = 0; i < 2; i++)
+    {
+        total.wins[i] += local.wins[i];
+        total.shotsToWin[i].insert(total.shotsToWin[i].end(),
+            local.shotsToWin[i].begin(), local.shotsToWin[i].end());
+    }
+    total.failures += local.failures;
+    total.mismatches += local.mismatches;
+    total.firstMismatch = min(total.firstMismatch, local.firstMismatch);
+}
+
+// Play games until the shared counter runs out, accumulating into a local result
+static void runWorker(const TournamentConfig& cfg, atomic<int>& nextGame,
+    GameRecordWriter* records, const OpeningBook* book, TournamentResult& total, mutex& totalMutex)
+{
+    TournamentResult local;
+    Arena arena;
+    Game g(cfg.rows, cfg.cols, cfg.seed,
+        cfg.useArena ? static_cast<pmr::memory_resource*>(&arena) : pmr::new_delete_resource());
+    addFleet(g, cfg.fleet);
+    g.setOpeningBook(book);
+
+    CountingPlayer p0(createTournamentPlayer(cfg, 0, g, nullptr), g);
+    CountingPlayer p1(createTournamentPlayer(cfg, 1, g, nullptr), g);
+    Board b0(g);
+    Board b1(g);
+    unique_ptr<GameRecorder> recorder;
+    if (records != nullptr)
+        recorder.reset(new GameRecorder(*records, g));
+
+    for (int k = nextGame++; k < cfg.nGames; k = nextGame++)
+    {
+        int shots;
+        int winner = playGame(cfg, g, p0, p1, b0, b1, k, recorder.get(), shots);
+        addGame(local, winner, shots);
+    }
+    mergeResult(local, total, totalMutex);
+}
+
+// Play games in lockstep until the shared counter runs out.  A worker takes
+// 2 * LANES games at a time and plays the even and the odd ones as two
+// batches, so player 0 moves first in every lane of one and player 1 in
+// every lane of the other.  Ships are placed by the players themselves,
+// exactly as Game::play would have them placed.
+static void runLockstepWorker(const TournamentConfig& cfg, atomic<int>& nextGame,
+    const OpeningBook* book, TournamentResult& total, mutex& totalMutex)
+{
+    const int LANES = LockstepEngine::LANES;
+    TournamentResult local;
+    Arena arena;
+    Game g(cfg.rows, cfg.cols, cfg.seed,
+        cfg.useArena ? static_cast<pmr::memory_resource*>(&arena) : pmr::new_delete_resource());
+    addFleet(g, cfg.fleet);
+    g.setOpeningBook(book);
+
+    CountingPlayer p0(createPlayer(cfg.type[0], cfg.type[0] + " 0", g), g);
+    CountingPlayer p1(createPlayer(cfg.type[1], cfg.type[1] + " 1", g), g);
+    Board b0(g);
+    Board b1(g);
+    CountingPlayer* players[2] = { &p0, &p1 };
+    Board* boards[2] = { &b0, &b1 };
+
+    LockstepEngine::Targeting targeting[2];
+    LockstepEngine::targetingOf(cfg.type[0], targeting[0]);
+    LockstepEngine::targetingOf(cfg.type[1], targeting[1]);
+    unique_ptr<LockstepEngine> engines[2];
+    engines[0].reset(new LockstepEngine(g, targeting[0], targeting[1]));
+    engines[1].reset(new LockstepEngine(g, targeting[1], targeting[0]));
+    int games[LANES];
+
+    for (int start = nextGame.fetch_add(2 * LANES); start < cfg.nGames; start = nextGame.fetch_add(2 * LANES))
+        for (int first = 0; first < 2; first++)
+        {
+            LockstepEngine& engine = *engines[first];
+            int nLanes = 0;
+            for (int k = start + first; k < start + 2 * LANES && k < cfg.nGames; k += 2)
+            {
+                g.reseed(Rng::mix(cfg.seed + k));
+                p0.reset();
+                p1.reset();
+                b0.reset();
+                b1.reset();
+                if (players[first]->placeShips(*boards[first]) &&
+                    players[1 - first]->placeShips(*boards[1 - first]) &&
+                    engine.load(nLanes, *boards[first], *boards[1 - first]))
+                    games[nLanes++] = k;
+                else
+                    local.failures++;
+            }
+            engine.run(nLanes);
+
+            for (int l = 0; l < nLanes; l++)
+            {
+                int w = engine.winner(l);
+                int winner = (w < 0 ? -1 : (w == 0 ? first : 1 - first));
+                int shots = (w < 0 ? 0 : engine.shots(l, w));
+                addGame(local, winner, shots);
+                if (cfg.lockstep == 2)
+                {
+                    int scalarShots;
+                    int scalarWinner = playGame(cfg, g, p0, p1, b0, b1, games[l], nullptr, scalarShots);
+                    if (scalarWinner != winner || scalarShots != shots)
+                    {
+                        local.mismatches++;
+                        local.firstMismatch = min(local.firstMismatch, games[l]);
+                    }
+                }
+            }
+        }
+    mergeResult(local, total, totalMutex);
+}
+
+// One of the -y games in flight: plays game after game until the shared
+// counter runs out, each as a GameTask, with its own game, players and
+// boards.  Games are set up exactly as playGame sets them up.
+class TournamentSlot final : public ResumableTask
+{
+public:
+    TournamentSlot(const TournamentConfig& cfg, atomic<int>& nextGame,
+        GameRecordWriter* records, const OpeningBook* book, ReplyTimer* timer)
+        : m_cfg(cfg), m_nextGame(nextGame),
+          m_game(cfg.rows, cfg.cols, cfg.seed,
+              cfg.useArena ? static_cast<pmr::memory_resource*>(&m_arena) : pmr::new_delete_resource()),
+          m_task(m_game), m_k(-1)
+    {
+        addFleet(m_game, cfg.fleet);
+        m_game.setOpeningBook(book);
+        m_players[0].reset(new CountingPlayer(createTournamentPlayer(cfg, 0, m_game, timer), m_game));
+        m_players[1].reset(new CountingPlayer(createTournamentPlayer(cfg, 1, m_game, timer), m_game));
+        m_boards[0].reset(new Board(m_game));
+        m_boards[1].reset(new Board(m_game));
+        if (records != nullptr)
+            m_recorder.reset(new GameRecorder(*records, m_game));
+    }
+
+    const TournamentResult& result() const { return m_result; }
+
+    bool resume(const function<void()>& wake) override
+    {
+        while (true)
+        {
+            if (m_k < 0 && !startNext())
+                return true;
+            if (!m_task.resume(wake))
+                return false;
+            finishGame();
+        }
+    }
+
+private:
+    // Start the next game of the tournament; false if there are none left
+    bool startNext()
+    {
+        int k = m_nextGame++;
+        if (k >= m_cfg.nGames)
+            return false;
+        m_k = k;
+        m_game.reseed(Rng::mix(m_cfg.seed + k));
+        m_players[0]->reset();
+        m_players[1]->reset();
+
+        // Alternate who moves first
+        int first = k % 2;
+        GameEventSink& sink = (m_recorder ? static_cast<GameEventSink&>(*m_recorder) : m_quiet);
+        if (m_recorder)
+            m_recorder->startGame(k, first);
+        m_task.start(m_players[first].get(), m_players[1 - first].get(),
+            *m_boards[first], *m_boards[1 - first], sink);
+        return true;
+    }
+
+    void finishGame()
+    {
+        Player* w = m_task.winner();
+        int winner = (w == m_players[0].get() ? 0 : (w == m_players[1].get() ? 1 : -1));
+        if (m_recorder)
+            m_recorder->endGame(*m_boards[0], *m_boards[1], winner);
+        addGame(m_result, winner, winner < 0 ? 0 : m_players[winner]->shots());
+        m_k = -1;
+    }
+
+    const TournamentConfig& m_cfg;
+    atomic<int>& m_nextGame;
+    Arena m_arena;
+    Game m_game;
+    GameTask m_task;
+    unique_ptr<CountingPlayer> m_players[2];
+    unique_ptr<Board> m_boards[2];
+    unique_ptr<GameRecorder> m_recorder;
+    NullEventSink m_quiet;
+    int m_k;                                // game being played, or -1
+    TournamentResult m_result;
+};
+
+// Play every game with up to cfg.inFlight of them going at once on
+// nThreads threads
+static void runMultiplexed(const TournamentConfig& cfg, int nThreads, atomic<int>& nextGame,
+    GameRecordWriter* records, const OpeningBook* book, TournamentResult& total, mutex& totalMutex)
+{
+    ReplyTimer timer;
+    vector<unique_ptr<TournamentSlot> > slots;
+    for (int i = 0; i < min(cfg.inFlight, cfg.nGames); i++)
+        slots.emplace_back(new TournamentSlot(cfg, nextGame, records, book, &timer));
+
+    // The calling thread plays too
+    ThreadPool pool(max(1, nThreads - 1));
+    GameScheduler scheduler(pool);
+    for (size_t i = 0; i < slots.size(); i++)
+        scheduler.add(slots[i].get());
+    scheduler.run(nThreads);
+
+    for (size_t i = 0; i < slots.size(); i++)
+        mergeResult(slots[i]->result(), total, totalMutex);
+}
+
+static double mean(const vector<int>& v)
+{
+    if (v.empty())
+        return 0;
+    double sum = 0;
+    for (size_t i = 0; i < v.size(); i++)
+        sum += v[i];
+    return sum / v.size();
+}
+
+static double median(vector<int> v)
+{
+    if (v.empty())
+        return 0;
+    size_t mid = v.size() / 2;
+    nth_element(v.begin(), v.begin() + mid, v.end());
+    if (v.size() % 2 == 1)
+        return v[mid];
+    int upper = v[mid];
+    int lower = *max_element(v.begin(), v.begin() + mid);
+    return (lower + upper) / 2.0;
+}
+
+int main(int argc, char* argv[])
+{
+    TournamentConfig cfg;
+    if (!parseArgs(argc, argv, cfg))
+    {
+        usage();
+        return 1;
+    }
+
+    if (cfg.rows < 1 || cfg.rows > MAXROWS || cfg.cols < 1 || cfg.cols > MAXCOLS)
+    {
+        cerr << "Board must be between 1x1 and " << MAXROWS << 'x' << MAXCOLS << endl;
+        return 1;
+    }
+
+    // Validate the configuration once before starting any threads
+    unique_ptr<OpeningBook> book;
+    if (!cfg.bookPath.empty())
+        book.reset(new OpeningBook(cfg.bookPath));
+    {
+        Game g(cfg.rows, cfg.cols);
+        if (!addFleet(g, cfg.fleet))
+            return 1;
+        if (book && !(book->isOpen() && g.setOpeningBook(book.get())))
+        {
+            cerr << cfg.bookPath << " is not an opening book for this board and fleet" << endl;
+            return 1;
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            Player* p = createPlayer(cfg.type[i], "check", g);
+            bool ok = (p != nullptr && !p->isHuman());
+            delete p;
+            if (!ok)
+            {
+                cerr << "Unknown or non-AI player type " << cfg.type[i] << endl;
+                return 1;
+            }
+            LockstepEngine::Targeting t;
+            if (cfg.lockstep != 0 && !LockstepEngine::targetingOf(cfg.type[i], t))
+            {
+                cerr << "-l needs players that target like awful or heat, not " << cfg.type[i] << endl;
+                return 1;
+            }
+        }
+        if (cfg.lockstep != 0 && !LockstepEngine::supports(g))
+        {
+            cerr << "-l needs a board of at most " << SMALL_BOARD_CELLS << " cells" << endl;
+            return 1;
+        }
+        if (cfg.lockstep != 0 && !cfg.recordPath.empty())
+        {
+            cerr << "-l cannot record games" << endl;
+            return 1;
+        }
+        if (cfg.lockstep != 0 && (cfg.delayMs > 0 || cfg.inFlight > 0))
+        {
+            cerr << "-l cannot be combined with -d or -y" << endl;
+            return 1;
+        }
+    }
+
+    int nThreads = cfg.nThreads;
+    if (nThreads == 0)
+        nThreads = max(1u, thread::hardware_concurrency());
+    nThreads = min(nThreads, cfg.nGames);
+
+    unique_ptr<GameRecordWriter> records;
+    if (!cfg.recordPath.empty())
+    {
+        GameRecordInfo info;
+        info.rows = cfg.rows;
+        info.cols = cfg.cols;
+        info.fleet = cfg.fleet;
+        info.type[0] = cfg.type[0];
+        info.type[1] = cfg.type[1];
+        records.reset(new GameRecordWriter(cfg.recordPath, info));
+        if (!records->isOpen())
+        {
+            cerr << "Cannot create " << cfg.recordPath << endl;
+            return 1;
+        }
+    }
+
+    TournamentResult result;
+    mutex resultMutex;
+    atomic<int> nextGame(0);
+
+    Profiler::enable(!cfg.profilePath.empty());
+    auto start = chrono::steady_clock::now();
+    if (cfg.inFlight > 0)
+        runMultiplexed(cfg, nThreads, nextGame, records.get(), book.get(), result, resultMutex);
+    else
+    {
+        vector<thread> workers;
+        for (int t = 0; t < nThreads; t++)
+            if (cfg.lockstep != 0)
+                workers.emplace_back(runLockstepWorker, cref(cfg), ref(nextGame), book.get(), ref(result), ref(resultMutex));
+            else
+                workers.emplace_back(runWorker, cref(cfg), ref(nextGame), records.get(), book.get(), ref(result), ref(resultMutex));
+        for (size_t t = 0; t < workers.size(); t++)
+            workers[t].join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%d games, %d threads, %dx%d board, %d ships, seed %llu\n",
+        cfg.nGames, nThreads, cfg.rows, cfg.cols, static_cast<int>(cfg.fleet.size()),
+        static_cast<unsigned long long>(cfg.seed));
+    for (int i = 0; i < 2; i++)
+        printf("  %-10s wins %6.2f%%   shots to win: mean %6.2f  median %6.1f\n",
+            cfg.type[i].c_str(), 100.0 * result.wins[i] / cfg.nGames,
+            mean(result.shotsToWin[i]), median(result.shotsToWin[i]));
+    if (result.failures > 0)
+        printf("  %d games could not be played (ship placement failed)\n", result.failures);
+    printf("  %.3f s, %.1f games/s\n", seconds, cfg.nGames / seconds);
+    if (cfg.lockstep == 2)
+    {
+        if (result.mismatches == 0)
+            printf("  every game matched the scalar path\n");
+        else
+        {
+            printf("  %d games differed from the scalar path; first is game %d\n",
+                result.mismatches, result.firstMismatch);
+            return 1;
+        }
+    }
+    if (records && !records->ok())
+    {
+        cerr << "Failed to write every game to " << cfg.recordPath << endl;
+        return 1;
+    }
+    if (!cfg.profilePath.empty())
+    {
+        Profiler::enable(false);
+        ofstream out(cfg.profilePath);
+        Profiler::writeJson(out);
+        if (!out)
+        {
+            cerr << "Cannot write " << cfg.profilePath << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
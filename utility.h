@@ -1,13 +0,0 @@
-#ifndef UTILITIES_DEFINED
-#define UTILITIES_DEFINED
-
-#include <vector>
-#include "globals.h"
-
-using namespace std;
-
-
-void eraseFromVector(int r, int c, vector<Point> vector);
-
-
-#endif 